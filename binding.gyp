@@ -3,12 +3,16 @@
     {
       "target_name": "clang_tool",
       "sources": [
-        "src/clang/clang_diagnostic.cpp",
-        "src/clang/clang_ressource_usage.cpp",
-        "src/clang/clang_tool.cpp",
-        "src/clang/clang_translation_unit.cpp",
-        "src/clang/clang_translation_unit_cache.cpp",
-        "src/clang/sha1.cpp",
+        "src/compilation_database.cpp",
+        "src/completion_buffer.cpp",
+        "src/completion_filter.cpp",
+        "src/content_hash.cpp",
+        "src/cursor_index.cpp",
+        "src/file_overlay.cpp",
+        "src/include_graph.cpp",
+        "src/signature_help.cpp",
+        "src/text_buffer.cpp",
+        "src/unit_cache.cpp",
         "src/bindings.cpp"
       ],
       "cflags_cc": [
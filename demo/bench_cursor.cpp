@@ -0,0 +1,143 @@
+// Times cursor lookups on a generated file, clang_getCursor for every position against the cursor index
+// Usage: npm run bench-cursor [-- functions]
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <clang-c/Index.h>
+
+#include "unit_cache.hpp"
+
+/// a struct and a few functions using it, repeated
+static uint32_t generate(const std::string& path, uint32_t functions) {
+    std::ofstream out(path.c_str(), std::ios::out | std::ios::trunc);
+    for (uint32_t i = 0; i < functions; ++i) {
+        std::string n = std::to_string(i);
+        out << "struct s" << n << " { int a; double b; int get() const { return a; } };\n"
+            << "static int f" << n << "(const s" << n << "& v, int n) {\n"
+            << "    int total = v.get() + n;\n"
+            << "    for (int j = 0; j < n; ++j) total += static_cast<int>(v.b) * j;\n"
+            << "    auto twice = [&](int x) { return x * 2 + total; };\n"
+            << "    return twice(total);\n"
+            << "}\n";
+    }
+
+    return functions * 7;
+}
+
+/// every column of every identifier, the same token is looked up several times
+static std::vector<uint32_t> positions(const std::string& path) {
+    std::vector<uint32_t> ret;
+    std::ifstream in(path.c_str());
+    std::string line;
+
+    for (uint32_t row = 1; std::getline(in, line); ++row) {
+        for (std::size_t i = 0; i < line.size(); ) {
+            if (!isalpha(line[i]) && line[i] != '_') {
+                ++i;
+                continue;
+            }
+
+            for (; i < line.size() && (isalnum(line[i]) || line[i] == '_'); ++i) {
+                ret.push_back(row);
+                ret.push_back(i + 1);
+            }
+        }
+    }
+
+    return ret;
+}
+
+/// converts and disposes a CXString
+static std::string spell(CXString str) {
+    const char* s = clang_getCString(str);
+    std::string ret = s ? s : "";
+    clang_disposeString(str);
+    return ret;
+}
+
+/// file, row and col of a cursor, what cursor_index stores per facet
+static clang::location where(CXCursor cursor) {
+    CXFile file;
+    unsigned row, col;
+    clang_getExpansionLocation(clang_getCursorLocation(cursor), &file, &row, &col, nullptr);
+
+    clang::location ret;
+    ret.file = file ? spell(clang_getFileName(file)) : std::string();
+    ret.row = row;
+    ret.col = col;
+    return ret;
+}
+
+/// runs and times fn
+template <typename F>
+static void measure(const char* label, F fn) {
+    auto start = std::chrono::steady_clock::now();
+    std::size_t n = fn();
+    auto end = std::chrono::steady_clock::now();
+
+    printf("%s: %zu lookups %.1f ms\n", label, n, std::chrono::duration<double, std::milli>(end - start).count());
+}
+
+int main(int argc, char** argv) {
+    uint32_t functions = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 2000;
+
+    char dir[] = "/tmp/clang-tool-bench-XXXXXX";
+    if (!mkdtemp(dir))
+        return 1;
+
+    std::string path = std::string(dir) + "/bench_cursor.cpp";
+    uint32_t lines = generate(path, functions);
+    std::vector<uint32_t> at = positions(path);
+    std::vector<std::string> args = {"-std=c++11"};
+    printf("%u lines, %zu positions\n", lines, at.size() / 2);
+
+    // baseline, a unit parsed the same way and asked for each position on its own
+    CXIndex index = clang_createIndex(0, 0);
+    const char* argv_clang[] = {"-std=c++11"};
+    CXTranslationUnit unit = clang_parseTranslationUnit(index, path.c_str(), argv_clang, 1, nullptr, 0,
+        clang_defaultEditingTranslationUnitOptions());
+
+    if (!unit)
+        return 1;
+
+    CXFile file = clang_getFile(unit, path.c_str());
+    measure("clang_getCursor", [&]() {
+        for (std::size_t i = 0; i < at.size(); i += 2) {
+            CXCursor cursor = clang_getCursor(unit, clang_getLocation(unit, file, at[i], at[i + 1]));
+            std::string type = spell(clang_getTypeSpelling(clang_getCursorType(cursor)));
+            clang::location declaration = where(clang_getCursorReferenced(cursor));
+            clang::location definition = where(clang_getCursorDefinition(cursor));
+        }
+
+        return at.size() / 2;
+    });
+
+    clang_disposeTranslationUnit(unit);
+    clang_disposeIndex(index);
+
+    // cursor_index, the first pass collects the extents
+    translation_unit tu(path);
+    if (!tu.parse(args, false, unsaved_files()))
+        return 1;
+
+    auto lookup = [&]() {
+        for (std::size_t i = 0; i < at.size(); i += 2)
+            tu.cursor_info(at[i], at[i + 1], cursor_field_default);
+
+        return at.size() / 2;
+    };
+
+    measure("cursor_index, cold", lookup);
+    measure("cursor_index, warm", lookup);
+
+    unlink(path.c_str());
+    rmdir(dir);
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Times loading a generated compile_commands.json, doesn't need libclang
+// Usage: npm run bench-database [-- entries]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "compilation_database.hpp"
+
+/// a few hundred targets with their own flags, like a large CMake project
+static void generate(const std::string& path, uint32_t entries, uint32_t revision) {
+    std::ofstream out(path.c_str(), std::ios::out | std::ios::trunc);
+    out << "[\n";
+
+    for (uint32_t i = 0; i < entries; ++i) {
+        uint32_t target = i % 400;
+        std::string file = "src/module" + std::to_string(target) + "/file" + std::to_string(i) + ".cpp";
+
+        out << (i ? ",\n" : "") << "{\"directory\": \"/project/build\", \"command\": \"/usr/bin/c++"
+            << " -DTARGET_" << target << " -DREVISION=" << revision
+            << " -I/project/include -I/project/src/module" << target << " -isystem /project/third_party/include"
+            << " -std=c++14 -O2 -g -Wall -Wextra -fPIC -o CMakeFiles/module" << target << ".dir/file" << i << ".cpp.o"
+            << " -c /project/" << file << "\", \"file\": \"/project/" << file << "\"}";
+    }
+
+    out << "\n]\n";
+}
+
+/// peak resident set size in MB
+static double peak_rss() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+/// runs and times fn
+template <typename F>
+static void measure(const char* label, F fn) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = fn();
+    auto end = std::chrono::steady_clock::now();
+
+    printf("%s: %s %.1f ms, peak rss %.1f MB\n", label, ok ? "ok" : "failed",
+        std::chrono::duration<double, std::milli>(end - start).count(), peak_rss());
+}
+
+int main(int argc, char** argv) {
+    uint32_t entries = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100000;
+
+    char dir[] = "/tmp/clang-tool-bench-XXXXXX";
+    if (!mkdtemp(dir))
+        return 1;
+
+    std::string path = std::string(dir) + "/compile_commands.json";
+    generate(path, entries, 0);
+    printf("%u entries, peak rss %.1f MB before loading\n", entries, peak_rss());
+
+    compilation_database db;
+    measure("first load", [&]() { return db.load(dir); });
+    measure("unchanged", [&]() { return db.unchanged(dir); });
+
+    // every argument set changes
+    generate(path, entries, 1);
+    measure("all changed", [&]() { return db.load(dir); });
+
+    unlink(path.c_str());
+    rmdir(dir);
+    return 0;
+}
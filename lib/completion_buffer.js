@@ -0,0 +1,105 @@
+// Decoder for the binary completion results returned by
+// cursorCandidatesAt(file, row, col, {binary: true}).
+//
+// Strings are only created when a field is read, so rendering the first few
+// entries of a large result set doesn't pay for the rest.
+//
+// var decode = require('clang_tool/lib/completion_buffer');
+// var res = decode(obj.cursorCandidatesAt(file, row, col, {binary: true, limit: 50}));
+// for (var i = 0; i < Math.min(res.length, 10); ++i)
+//     console.log(res.name(i), res.get(i).info);
+
+var NONE = 0xFFFFFFFF;
+var HEADER = 5;
+var RECORD = 9;
+
+function CompletionBuffer(buffer) {
+    this.buffer = Buffer.isBuffer(buffer) ? buffer : Buffer.from(buffer);
+
+    if (this.u32(0) !== 2)
+        throw new Error("Unsupported completion buffer version " + this.u32(0));
+
+    this.length = this.u32(1);
+    this.total = this.u32(2);
+
+    var argCount = this.u32(3);
+    var stringCount = this.u32(4);
+
+    this.records = HEADER * 4;
+    this.args = this.records + this.length * RECORD * 4;
+    this.offsets = this.args + argCount * 4;
+    this.strings = this.offsets + (stringCount + 1) * 4;
+    this.cache = new Array(stringCount);
+}
+
+CompletionBuffer.prototype.u32 = function(idx) {
+    return this.buffer.readUInt32LE(idx * 4);
+};
+
+CompletionBuffer.prototype.field = function(i, f) {
+    return this.buffer.readUInt32LE(this.records + (i * RECORD + f) * 4);
+};
+
+/// Returns string number idx of the string table
+CompletionBuffer.prototype.string = function(idx) {
+    if (idx === NONE)
+        return undefined;
+
+    var s = this.cache[idx];
+    if (s === undefined) {
+        var start = this.buffer.readUInt32LE(this.offsets + idx * 4);
+        var end = this.buffer.readUInt32LE(this.offsets + (idx + 1) * 4);
+        s = this.cache[idx] = this.buffer.toString('utf8', this.strings + start, this.strings + end);
+    }
+
+    return s;
+};
+
+CompletionBuffer.prototype.name = function(i) { return this.string(this.field(i, 0)); };
+CompletionBuffer.prototype.returnType = function(i) { return this.string(this.field(i, 1)); };
+CompletionBuffer.prototype.brief = function(i) { return this.string(this.field(i, 2)); };
+CompletionBuffer.prototype.type = function(i) { return this.field(i, 3); };
+CompletionBuffer.prototype.priority = function(i) { return this.field(i, 4); };
+CompletionBuffer.prototype.snippet = function(i) { return this.string(this.field(i, 7)); };
+CompletionBuffer.prototype.label = function(i) { return this.string(this.field(i, 8)); };
+
+/// Returns the argument strings of entry i
+CompletionBuffer.prototype.info = function(i) {
+    var first = this.field(i, 5);
+    var count = this.field(i, 6);
+    var ret = new Array(count);
+
+    for (var j = 0; j < count; ++j)
+        ret[j] = this.string(this.buffer.readUInt32LE(this.args + (first + j) * 4));
+
+    return ret;
+};
+
+/// Returns entry i in the same shape as the object results
+CompletionBuffer.prototype.get = function(i) {
+    var entry = {
+        name: this.name(i),
+        return_type: this.returnType(i),
+        type: this.type(i),
+        priority: this.priority(i),
+        info: this.info(i)
+    };
+
+    var brief = this.brief(i);
+    if (brief !== undefined)
+        entry.brief = brief;
+
+    var snippet = this.snippet(i);
+    if (snippet !== undefined) {
+        entry.snippet = snippet;
+        entry.label = this.label(i);
+    }
+
+    return entry;
+};
+
+module.exports = function(buffer) {
+    return new CompletionBuffer(buffer);
+};
+
+module.exports.CompletionBuffer = CompletionBuffer;
@@ -21,20 +21,768 @@
 */
 
 #include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
 #include <vector>
 
 #include "clang/clang_tool.hpp"
+#include "completion_buffer.hpp"
+#include "completion_filter.hpp"
 #include "bindings.hpp"
 
 /// persistance between calls
 Nan::Persistent<FunctionTemplate> node_tool::constructor;
 
+/// reads an optional boolean property
+static bool option_bool(Local<Object> obj, const char* name, bool def) {
+    Local<Value> v = Nan::Get(obj, Nan::New<String>(name).ToLocalChecked()).ToLocalChecked();
+    return v->IsBoolean() ? v->BooleanValue() : def;
+}
+
+/// whether v holds file content, either a string or raw bytes
+static bool is_content(Local<Value> v) {
+    return v->IsString() || v->IsArrayBufferView() || v->IsSharedArrayBuffer();
+}
+
+/// copies file content into out, raw bytes are taken as UTF-8 without transcoding
+static void read_content(Local<Value> v, text_buffer& out) {
+    if (node::Buffer::HasInstance(v)) {
+        out.assign(node::Buffer::Data(v), node::Buffer::Length(v));
+    } else if (v->IsArrayBufferView()) {
+        Local<ArrayBufferView> view = Local<ArrayBufferView>::Cast(v);
+        const char* data = static_cast<const char*>(view->Buffer()->GetContents().Data());
+        out.assign(data + view->ByteOffset(), view->ByteLength());
+    } else if (v->IsSharedArrayBuffer()) {
+        SharedArrayBuffer::Contents contents = Local<SharedArrayBuffer>::Cast(v)->GetContents();
+        out.assign(static_cast<const char*>(contents.Data()), contents.ByteLength());
+    } else {
+        String::Utf8Value str(v);
+        out.assign(*str, str.length());
+    }
+}
+
+/// reads a {row, col} object
+static bool option_position(Local<Value> v, uint32_t& row, uint32_t& col) {
+    if (!v->IsObject())
+        return false;
+
+    Local<Object> obj = Local<Object>::Cast(v);
+    Local<Value> r = Nan::Get(obj, Nan::New<String>("row").ToLocalChecked()).ToLocalChecked();
+    Local<Value> c = Nan::Get(obj, Nan::New<String>("col").ToLocalChecked()).ToLocalChecked();
+    if (!r->IsNumber() || !c->IsNumber())
+        return false;
+
+    row = r->Uint32Value();
+    col = c->Uint32Value();
+    return true;
+}
+
+/// converts a completion options object
+static completion_options option_completion(Local<Object> obj) {
+    completion_options opts;
+    opts.macros = option_bool(obj, "macros", true);
+    opts.patterns = option_bool(obj, "patterns", true);
+    opts.brief = option_bool(obj, "brief", true);
+
+    Local<Value> kinds = Nan::Get(obj, Nan::New<String>("kinds").ToLocalChecked()).ToLocalChecked();
+    if (kinds->IsArray()) {
+        Local<Array> arr = Local<Array>::Cast(kinds);
+        for (uint32_t i = 0; i < arr->Length(); ++i) {
+            auto kind = arr->Get(i)->Uint32Value();
+            if (kind <= static_cast<uint32_t>(clang::completion_type::unkown_t))
+                opts.accept_kind(static_cast<clang::completion_type>(kind));
+        }
+    }
+
+    Local<Value> filter = Nan::Get(obj, Nan::New<String>("filter").ToLocalChecked()).ToLocalChecked();
+    if (filter->IsString())
+        opts.filter = *String::Utf8Value(filter);
+
+    opts.fuzzy = option_bool(obj, "fuzzy", true);
+
+    Local<Value> contexts = Nan::Get(obj, Nan::New<String>("contexts").ToLocalChecked()).ToLocalChecked();
+    if (contexts->IsNumber())
+        opts.contexts = static_cast<uint64_t>(contexts->NumberValue());
+
+    Local<Value> limit = Nan::Get(obj, Nan::New<String>("limit").ToLocalChecked()).ToLocalChecked();
+    if (limit->IsNumber())
+        opts.limit = limit->Uint32Value();
+
+    opts.binary = option_bool(obj, "binary", false);
+    opts.snippet = option_bool(obj, "snippet", false);
+
+    return opts;
+}
+
+/// converts a cursor fields object
+static uint32_t option_cursor_fields(Local<Object> obj) {
+    uint32_t fields = 0;
+    if (option_bool(obj, "type", true))
+        fields |= cursor_field_type;
+    if (option_bool(obj, "declaration", true))
+        fields |= cursor_field_declaration;
+    if (option_bool(obj, "definition", true))
+        fields |= cursor_field_definition;
+    if (option_bool(obj, "docs", false))
+        fields |= cursor_field_docs;
+
+    return fields;
+}
+
+/// attaches the generation to a response
+static void set_generation(Local<Object> obj, uint32_t generation) {
+    Nan::Set(obj, Nan::New<String>("generation").ToLocalChecked(), Nan::New<Number>(generation));
+}
+
+/// reads a property of an options object
+static Local<Value> option_value(Local<Object> obj, const char* name) {
+    return Nan::Get(obj, Nan::New<String>(name).ToLocalChecked()).ToLocalChecked();
+}
+
+/// converts a location
+static Local<Object> location_object(const clang::location& loc) {
+    Local<Object> ret = Nan::New<Object>();
+    Nan::Set(ret, Nan::New<String>("file").ToLocalChecked(), Nan::New<String>(loc.file.c_str()).ToLocalChecked());
+    Nan::Set(ret, Nan::New<String>("row").ToLocalChecked(), Nan::New<Number>(loc.row));
+    Nan::Set(ret, Nan::New<String>("col").ToLocalChecked(), Nan::New<Number>(loc.col));
+    return ret;
+}
+
+/// copies values into a new Int32Array
+static Local<Int32Array> int32_array(const std::vector<int32_t>& values) {
+    Local<ArrayBuffer> buffer = ArrayBuffer::New(Isolate::GetCurrent(), values.size() * sizeof(int32_t));
+    if (!values.empty())
+        memcpy(buffer->GetContents().Data(), &values[0], values.size() * sizeof(int32_t));
+
+    return Int32Array::New(buffer, 0, values.size());
+}
+
+/// converts a completion candidate
+static Local<Object> completion_object(const completion_candidate& candidate, const completion_options& opts) {
+    Local<Object> entry = Nan::New<Object>();
+    Local<Array> info = Nan::New<Array>();
+    Nan::Set(entry, Nan::New<String>("name").ToLocalChecked(), Nan::New<String>(candidate.name.c_str()).ToLocalChecked());
+    Nan::Set(entry, Nan::New<String>("return_type").ToLocalChecked(), Nan::New<String>(candidate.return_type.c_str()).ToLocalChecked());
+    Nan::Set(entry, Nan::New<String>("type").ToLocalChecked(), Nan::New<Number>(static_cast<uint32_t>(candidate.type)));
+    Nan::Set(entry, Nan::New<String>("priority").ToLocalChecked(), Nan::New<Number>(candidate.priority));
+
+    if (opts.brief)
+        Nan::Set(entry, Nan::New<String>("brief").ToLocalChecked(), Nan::New<String>(candidate.brief.c_str()).ToLocalChecked());
+
+    if (opts.snippet) {
+        Nan::Set(entry, Nan::New<String>("snippet").ToLocalChecked(), Nan::New<String>(candidate.snippet.c_str()).ToLocalChecked());
+        Nan::Set(entry, Nan::New<String>("label").ToLocalChecked(), Nan::New<String>(candidate.label.c_str()).ToLocalChecked());
+    }
+
+    for (uint32_t i = 0; i < candidate.args.size(); ++i) {
+        Nan::Set(info, i, Nan::New<String>(candidate.args[i].c_str()).ToLocalChecked());
+    }
+
+    Nan::Set(entry, Nan::New<String>("info").ToLocalChecked(), info);
+    return entry;
+}
+
 /// constructor
-node_tool::node_tool() : Nan::ObjectWrap() {}
+node_tool::node_tool()
+    : Nan::ObjectWrap(), budget(0), epoch(0), prewarms(0), completion_flags(completion_options().flags()),
+      args_version(0) {}
 
 /// destructor
 node_tool::~node_tool() {}
 
+/// apply deferred content
+void node_tool::flush(const char* path) {
+    flush_includes(path);
+
+    bool outdated = stale.erase(path);
+    bool switched = unchecked.erase(path);
+    if (!pending.erase(path) && !outdated && !switched)
+        return;
+
+    // pinned files keep answering from the last snapshot
+    if (pinned.count(path)) {
+        reparse(path);
+        invalidate(path);
+        return;
+    }
+
+    // files including it see the new content with their next parse
+    if (index(path, outdated))
+        invalidate(path);
+}
+
+/// flush included headers
+void node_tool::flush_includes(const char* path) {
+    // edited headers have to be handed to clang before the files including them are parsed
+    std::vector<std::string> headers;
+    for (auto &file : pending) {
+        auto deps = includes.dependents(file);
+        if (std::find(deps.begin(), deps.end(), path) != deps.end())
+            headers.push_back(file);
+    }
+
+    for (auto &header : headers)
+        flush(header.c_str());
+}
+
+/// only unsaved content outstanding
+bool node_tool::deferred(const char* path) {
+    if (!pending.count(path) || stale.count(path) || unchecked.count(path) || pinned.count(path))
+        return false;
+
+    // a file that was never parsed is parsed with its content right away
+    auto r = routes.find(path);
+    if (r == routes.end())
+        return tool.contains(path) && unsaved.count(path);
+
+    auto t = tools.find(r->second);
+    return t != tools.end() && t->second->contains(path) && unsaved.count(path);
+}
+
+/// hand content to the shared index
+bool node_tool::index(const char* path, bool force) {
+    // a file moving to another argument set is dropped from the previous one
+    uint32_t set = route(path);
+    auto r = routes.find(path);
+    if (r != routes.end() && r->second != set) {
+        drop(path, r->second);
+        force = true;
+    }
+
+    routes[path] = set;
+    unit_cache& t = shared(set);
+
+    auto last = indexed.find(path);
+    auto content = unsaved.find(path);
+
+    indexed_file next;
+    next.unsaved = content != unsaved.end();
+
+    if (next.unsaved) {
+        // being edited, outline units become full ones
+        outlined.erase(path);
+
+        text_buffer& buffer = content->second;
+        next.revision = buffer.revision();
+        next.length = buffer.size();
+        bool known = !force && last != indexed.end() && last->second.unsaved;
+
+        // not edited since
+        if (known && last->second.revision == next.revision)
+            return false;
+
+        const std::string& value = buffer.view();
+
+        // edited back to the same size, possibly the same content, e.g. sent again or undone
+        if (known && last->second.length == next.length) {
+            next.hash = content_hash(value);
+            next.hashed = true;
+
+            if (last->second.hashed && last->second.hash == next.hash) {
+                last->second.revision = next.revision;
+                return false;
+            }
+        }
+
+        t.index_touch(path, unsaved_snapshot());
+    } else {
+        bool stamped = next.stamp.read(path);
+        bool known = !force && stamped && last != indexed.end() && !last->second.unsaved;
+
+        // metadata is enough to tell nothing changed, skip reading the file
+        if (known && last->second.stamp == next.stamp)
+            return false;
+
+        // rewritten with the same size, possibly identical, e.g. saved without changes
+        std::string disk;
+        if (known && last->second.stamp.size == next.stamp.size && this->content(path, disk)) {
+            next.hash = content_hash(disk);
+            next.hashed = true;
+
+            if (last->second.hashed && last->second.hash == next.hash) {
+                last->second.stamp = next.stamp;
+                return false;
+            }
+        }
+
+        t.index_touch(path, unsaved_snapshot(), outlined.count(path) != 0);
+    }
+
+    includes.update(path, t.tu_inclusions(path));
+
+    indexed[path] = next;
+    ++epoch;
+    evict();
+    return true;
+}
+
+/// new content
+uint32_t node_tool::touched(const char* path) {
+    return ++generations[path];
+}
+
+/// current generation
+uint32_t node_tool::generation(const char* path) const {
+    auto it = generations.find(path);
+    return it == generations.end() ? 0 : it->second;
+}
+
+/// minimum generation
+bool node_tool::reached(const char* path, Local<Value> min) {
+    if (!min->IsNumber())
+        return true;
+
+    // requests are handled in order, if the content isn't there yet it was never sent
+    if (min->Uint32Value() > generation(path)) {
+        Nan::ThrowError("Requested generation has not been indexed");
+        return false;
+    }
+
+    // the snapshot of a pinned file may be behind, wait by updating it in place
+    auto it = pinned.find(path);
+    if (it != pinned.end() && min->Uint32Value() > it->second.front_generation) {
+        it->second.front->index_touch(path, unsaved_snapshot());
+
+        includes.update(path, it->second.front->tu_inclusions(path));
+        it->second.front_generation = generation(path);
+        ++epoch;
+    }
+
+    return true;
+}
+
+/// on the index
+bool node_tool::known(const char* path) {
+    if (tool_for(path).contains(path))
+        return true;
+
+    Nan::ThrowError("File is not on the index, add it with indexTouch first");
+    return false;
+}
+
+/// tool for path
+unit_cache& node_tool::tool_for(const char* path) {
+    auto it = pinned.find(path);
+    if (it != pinned.end())
+        return *it->second.front;
+
+    auto r = routes.find(path);
+    return r == routes.end() ? tool : shared(r->second);
+}
+
+/// generation answered from
+uint32_t node_tool::served(const char* path) const {
+    auto it = pinned.find(path);
+    return it == pinned.end() ? generation(path) : it->second.front_generation;
+}
+
+/// argument set of a file
+uint32_t node_tool::route(const char* path) {
+    uint32_t set = database.lookup(path);
+
+    // headers don't have their own entry, take the closest file including them
+    if (!set) {
+        for (auto &dep : includes.dependents(path)) {
+            set = database.lookup(dep);
+            if (set)
+                break;
+        }
+    }
+
+    if (configuration.empty())
+        return set;
+
+    // the configuration's arguments are added to the file's own
+    auto key = std::make_pair(set, configuration);
+    auto it = combined.find(key);
+    if (it == combined.end()) {
+        std::vector<std::string> all = set ? database.arguments(set) : args;
+        const std::vector<std::string>& extra = configurations[configuration];
+        all.insert(all.end(), extra.begin(), extra.end());
+        it = combined.insert(std::make_pair(key, database.add_set(all))).first;
+    }
+
+    return it->second;
+}
+
+/// tool of an argument set
+unit_cache& node_tool::shared(uint32_t set) {
+    if (!set)
+        return tool;
+
+    std::shared_ptr<unit_cache>& t = tools[set];
+    if (!t) {
+        t = std::make_shared<unit_cache>();
+        apply_args(*t, set);
+    }
+
+    return *t;
+}
+
+/// file removal from a set
+void node_tool::drop(const char* path, uint32_t set) {
+    // creating a tool just to empty it would ask the database for a set it may have dropped
+    if (!set) {
+        tool.index_remove(path);
+        return;
+    }
+
+    auto t = tools.find(set);
+    if (t != tools.end())
+        t->second->index_remove(path);
+}
+
+/// effective arguments
+std::vector<std::string> node_tool::arguments(uint32_t set) const {
+    std::vector<std::string> ret = set ? database.arguments(set) : args;
+    if (!external_overlay.empty()) {
+        ret.push_back("-ivfsoverlay");
+        ret.push_back(external_overlay);
+    }
+
+    // later overlays take precedence
+    if (!overlay.file().empty()) {
+        ret.push_back("-ivfsoverlay");
+        ret.push_back(overlay.file());
+    }
+
+    return ret;
+}
+
+/// arguments
+void node_tool::apply_args(unit_cache& t, uint32_t set) const {
+    std::vector<std::string> all = arguments(set);
+    std::vector<const char*> pointers;
+    for (auto &arg : all)
+        pointers.push_back(arg.c_str());
+
+    t.arguments_set(pointers.empty() ? nullptr : &pointers[0], pointers.size());
+}
+
+/// arguments of all shared tools
+void node_tool::apply_args() {
+    apply_args(tool, 0);
+    for (auto &entry : tools)
+        apply_args(*entry.second, entry.first);
+}
+
+/// dependents of a header
+void node_tool::invalidate(const char* path, bool renew) {
+    std::vector<std::string> files;
+    for (auto &dep : includes.dependents(path)) {
+        // headers in between aren't parsed on their own
+        if (pinned.count(dep) || indexed.count(dep))
+            files.push_back(dep);
+    }
+
+    // pinned files are the ones being looked at, get them going first
+    std::stable_partition(files.begin(), files.end(), [this](const std::string& dep) {
+        return pinned.count(dep) != 0;
+    });
+
+    // inactive configurations parse them again once they are switched to
+    for (auto &state : parked) {
+        for (auto &dep : files)
+            state.second.indexed.erase(dep);
+    }
+
+    for (auto &dep : files) {
+        touched(dep.c_str());
+
+        // a reparse may keep using a preamble built from unsaved content that is gone
+        if (renew) {
+            tool.index_renew(dep.c_str());
+            for (auto &entry : tools)
+                entry.second->index_renew(dep.c_str());
+        }
+
+        auto it = pinned.find(dep);
+        if (it == pinned.end()) {
+            stale.insert(dep);
+            continue;
+        }
+
+        // back may be in use by a worker, it is renewed by the next one
+        if (renew) {
+            it->second.front->index_renew(dep.c_str());
+            it->second.renew = true;
+        }
+
+        reparse(dep);
+    }
+
+    if (!files.empty())
+        ++epoch;
+}
+
+/// configuration switch
+bool node_tool::use_configuration(const std::string& name) {
+    if (!name.empty() && !configurations.count(name)) {
+        Nan::ThrowError("Unknown configuration");
+        return false;
+    }
+
+    if (name == configuration)
+        return true;
+
+    // the translation units of the previous configuration stay where they are
+    std::set<std::string> files;
+    for (auto &entry : routes)
+        files.insert(entry.first);
+
+    configuration_state& previous = parked[configuration];
+    previous.routes.swap(routes);
+    previous.indexed.swap(indexed);
+    configuration = name;
+
+    auto next = parked.find(name);
+    if (next != parked.end()) {
+        routes.swap(next->second.routes);
+        indexed.swap(next->second.indexed);
+        parked.erase(next);
+    }
+
+    for (auto &entry : routes)
+        files.insert(entry.first);
+
+    // unchanged files are answered from this configuration's translation units right away, their
+    // content and so their generation stays the same
+    for (auto &file : files) {
+        if (!pinned.count(file))
+            unchecked.insert(file);
+    }
+
+    // pinned files have a single pair of buffers, they are reparsed
+    retarget();
+    end_sessions();
+    ++epoch;
+    evict();
+    return true;
+}
+
+/// configuration option
+bool node_tool::configure(Local<Value> options) {
+    if (!options->IsObject())
+        return true;
+
+    Local<Value> name = option_value(Local<Object>::Cast(options), "configuration");
+    if (name->IsString())
+        return use_configuration(*String::Utf8Value(name));
+
+    return !name->IsNull() || use_configuration(std::string());
+}
+
+/// end completion sessions
+void node_tool::end_sessions() {
+    session.clear();
+    prewarmed.clear();
+    signatures.clear();
+    ++prewarms;
+}
+
+/// new arguments
+void node_tool::args_changed() {
+    apply_args();
+    indexed.clear();
+    for (auto &state : parked)
+        state.second.indexed.clear();
+
+    end_sessions();
+    ++epoch;
+
+    // pinned files pick up the arguments with their next reparse
+    ++args_version;
+    for (auto &entry : pinned)
+        reparse(entry.first);
+}
+
+/// argument set changes
+bool node_tool::retarget() {
+    bool changed = false;
+
+    // files move the next time they are queried
+    for (auto it = routes.begin(); it != routes.end();) {
+        if (it->second == route(it->first.c_str())) {
+            ++it;
+            continue;
+        }
+
+        drop(it->first.c_str(), it->second);
+        stale.insert(it->first);
+        indexed.erase(it->first);
+        touched(it->first.c_str());
+        it = routes.erase(it);
+        changed = true;
+    }
+
+    // drop the tools of sets no longer in use, all of their files have moved
+    for (auto it = tools.begin(); it != tools.end();) {
+        if (database.contains(it->first))
+            ++it;
+        else
+            it = tools.erase(it);
+    }
+
+    // inactive configurations forget files of those sets, they are routed again once switched to
+    for (auto &state : parked) {
+        for (auto r = state.second.routes.begin(); r != state.second.routes.end();) {
+            if (!r->second || database.contains(r->second)) {
+                ++r;
+                continue;
+            }
+
+            state.second.indexed.erase(r->first);
+            r = state.second.routes.erase(r);
+        }
+    }
+
+    for (auto &entry : pinned) {
+        uint32_t set = route(entry.first.c_str());
+        if (set == entry.second.set)
+            continue;
+
+        entry.second.set = set;
+        rearm(entry.first);
+        changed = true;
+    }
+
+    if (changed) {
+        end_sessions();
+        ++epoch;
+    }
+
+    return changed;
+}
+
+/// memory budget
+void node_tool::evict() {
+    if (!budget || parked.empty())
+        return;
+
+    double total = 0;
+    std::map<uint32_t, std::map<std::string, double>> usage;
+    for (auto &s : tool.index_status()) {
+        usage[0][s.first] = s.second;
+        total += s.second;
+    }
+
+    for (auto &entry : tools) {
+        for (auto &s : entry.second->index_status()) {
+            usage[entry.first][s.first] = s.second;
+            total += s.second;
+        }
+    }
+
+    // pinned files count, but aren't evicted
+    for (auto &entry : pinned) {
+        double front = 0;
+        for (auto &s : entry.second.front->index_status())
+            front += s.second;
+
+        total += front;
+        if (entry.second.busy) {
+            total += front;
+        } else {
+            for (auto &s : entry.second.back->index_status())
+                total += s.second;
+        }
+    }
+
+    if (total <= budget)
+        return;
+
+    // translation units the active configuration uses aren't candidates, even if a parked one shares them
+    std::vector<std::pair<double, std::pair<std::string, uint32_t>>> victims;
+    std::set<std::pair<std::string, uint32_t>> seen;
+    for (auto &state : parked) {
+        for (auto &entry : state.second.routes) {
+            auto r = routes.find(entry.first);
+            if ((r != routes.end() && r->second == entry.second) || !seen.insert(entry).second)
+                continue;
+
+            auto u = usage[entry.second].find(entry.first);
+            victims.push_back(std::make_pair(u == usage[entry.second].end() ? 0 : u->second, entry));
+        }
+    }
+
+    std::sort(victims.rbegin(), victims.rend());
+    for (auto &victim : victims) {
+        if (total <= budget)
+            break;
+
+        const std::string& path = victim.second.first;
+        uint32_t set = victim.second.second;
+        drop(path.c_str(), set);
+        total -= victim.first;
+
+        for (auto &state : parked) {
+            auto r = state.second.routes.find(path);
+            if (r == state.second.routes.end() || r->second != set)
+                continue;
+
+            state.second.routes.erase(r);
+            state.second.indexed.erase(path);
+        }
+    }
+}
+
+/// new arguments for a pinned file
+void node_tool::rearm(const std::string& path) {
+    // both buffers have to be given the arguments, front once it has been swapped to the back
+    pinned_file& file = pinned[path];
+    file.front_args = ~args_version;
+    file.back_args = ~args_version;
+    touched(path.c_str());
+    reparse(path);
+}
+
+/// overlays changed
+void node_tool::renew() {
+    tool.index_renew_all();
+    for (auto &entry : tools)
+        entry.second->index_renew_all();
+
+    for (auto &entry : pinned) {
+        entry.second.front->index_renew_all();
+        entry.second.renew = true;
+    }
+}
+
+/// all unsaved content
+unsaved_files node_tool::unsaved_snapshot() {
+    unsaved_files ret;
+    ret.reserve(unsaved.size());
+
+    for (auto &entry : unsaved) {
+        unsaved_file file;
+        file.path = entry.first;
+        file.content = entry.second.share();
+        ret.push_back(file);
+    }
+
+    return ret;
+}
+
+/// file content
+bool node_tool::content(const char* path, std::string& out) {
+    auto it = unsaved.find(path);
+    if (it != unsaved.end()) {
+        out = it->second.view();
+        return true;
+    }
+
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file)
+        return false;
+
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    out = ss.str();
+    return true;
+}
+
 /// new
 NAN_METHOD(node_tool::New) {
 
@@ -44,6 +792,166 @@ NAN_METHOD(node_tool::New) {
     info.GetReturnValue().Set(info.This());
 }
 
+/// runs a completion in the background and parks the results in prewarmed
+class prewarm_worker : public Nan::AsyncWorker {
+public:
+    prewarm_worker(node_tool* instance, const std::string& path, uint32_t row, uint32_t col)
+        : Nan::AsyncWorker(nullptr), instance(instance), path(path), row(row), col(col),
+          ticket(++instance->prewarms), unit(instance->tool_for(path.c_str()).unit(path.c_str())),
+          flags(instance->completion_flags), contexts(0)
+    {
+        // shared with the buffer, edits arriving meanwhile don't touch it
+        auto it = instance->unsaved.find(path);
+        if (it != instance->unsaved.end())
+            content = it->second.share();
+
+        instance->Ref();
+    }
+
+    ~prewarm_worker() {
+        instance->Unref();
+    }
+
+    void Execute() {
+        // unit has its own lock, the main thread is free to serve other files
+        try {
+            candidates = unit->complete(row, col, flags, content ? content->data() : nullptr,
+                content ? content->size() : 0, &contexts);
+        } catch (...) {
+            SetErrorMessage("Completion failed");
+        }
+    }
+
+    void HandleOKCallback() {
+        // a newer prewarm was queued or the sessions ended since, the results would be stale
+        if (ticket != instance->prewarms)
+            return;
+
+        instance->prewarmed.candidates.swap(candidates);
+        instance->prewarmed.path = path;
+        instance->prewarmed.row = row;
+        instance->prewarmed.col = col;
+        instance->prewarmed.filter.clear();
+        instance->prewarmed.flags = flags;
+        instance->prewarmed.contexts = contexts;
+    }
+
+    /// speculative, the next request will report the problem
+    void HandleErrorCallback() {}
+private:
+    node_tool* instance;
+    std::string path;
+    uint32_t row;
+    uint32_t col;
+    uint32_t ticket;
+    std::shared_ptr<translation_unit> unit;
+    std::shared_ptr<const std::string> content;
+    unsigned flags;
+    unsigned long long contexts;
+    std::vector<completion_candidate> candidates;
+};
+
+/// reparses the back buffer of a pinned file
+class reparse_worker : public Nan::AsyncWorker {
+public:
+    reparse_worker(node_tool* instance, const std::string& path, const node_tool::pinned_file& file)
+        : Nan::AsyncWorker(nullptr), instance(instance), path(path), back(file.back),
+          generation(instance->generation(path.c_str())), args_version(instance->args_version),
+          set_args(file.back_args != instance->args_version), renew(file.renew),
+          args(instance->arguments(instance->route(path.c_str()))), unsaved(instance->unsaved_snapshot())
+    {
+        instance->Ref();
+    }
+
+    ~reparse_worker() {
+        instance->Unref();
+    }
+
+    void Execute() {
+        // back is only ever used by this worker, no need to lock
+        try {
+            if (set_args) {
+                std::vector<const char*> pointers;
+                for (auto &arg : args)
+                    pointers.push_back(arg.c_str());
+
+                back->arguments_set(pointers.empty() ? nullptr : &pointers[0], pointers.size());
+            }
+
+            if (renew)
+                back->index_renew(path.c_str());
+
+            back->index_touch(path.c_str(), unsaved);
+        } catch (...) {
+            SetErrorMessage("Reparse failed");
+        }
+    }
+
+    void HandleOKCallback() {
+        instance->reparsed(path, back, generation, args_version, true);
+    }
+
+    void HandleErrorCallback() {
+        instance->reparsed(path, back, generation, args_version, false);
+    }
+private:
+    node_tool* instance;
+    std::string path;
+    std::shared_ptr<unit_cache> back;
+    uint32_t generation;
+    uint32_t args_version;
+    bool set_args;
+    bool renew;
+    std::vector<std::string> args;
+    unsaved_files unsaved;
+};
+
+/// schedule reparse
+void node_tool::reparse(const std::string& path) {
+    pinned_file& file = pinned[path];
+    if (file.busy) {
+        file.dirty = true;
+        return;
+    }
+
+    file.busy = true;
+    file.dirty = false;
+    Nan::AsyncQueueWorker(new reparse_worker(this, path, file));
+    file.renew = false;
+}
+
+/// swap buffers
+void node_tool::reparsed(const std::string& path, const std::shared_ptr<unit_cache>& back, uint32_t generation,
+    uint32_t args_version, bool ok)
+{
+    // unpinned or cleared in the meantime
+    auto it = pinned.find(path);
+    if (it == pinned.end() || it->second.back != back)
+        return;
+
+    pinned_file& file = it->second;
+    file.busy = false;
+
+    // the front was brought further in place by reached() while this ran, swapping would go back in time
+    if (ok && generation < file.front_generation) {
+        file.dirty = true;
+        ok = false;
+    }
+
+    if (ok) {
+        std::swap(file.front, file.back);
+        file.back_args = file.front_args;
+        file.front_args = args_version;
+        file.front_generation = generation;
+        includes.update(path, file.front->tu_inclusions(path.c_str()));
+        ++epoch;
+    }
+
+    // the old front is behind now, bring it up to date if anything changed since
+    if (file.dirty || (ok && (file.front_generation != this->generation(path.c_str()) || file.front_args != args_version)))
+        reparse(path);
+}
+
 /// initializes the njs obj
 void node_tool::Init(Handle<Object> target) {
     // Wrap new and make it persistend
@@ -57,6 +965,7 @@ void node_tool::Init(Handle<Object> target) {
     Nan::SetPrototypeMethod(local_function_template, "setArgs",             setArgs);
     Nan::SetPrototypeMethod(local_function_template, "indexTouch",          indexTouch);
     Nan::SetPrototypeMethod(local_function_template, "indexTouchUnsaved",   indexTouchUnsaved);
+    Nan::SetPrototypeMethod(local_function_template, "indexApplyEdits",     indexApplyEdits);
     Nan::SetPrototypeMethod(local_function_template, "indexStatus",         indexStatus);
     Nan::SetPrototypeMethod(local_function_template, "indexClear",          indexClear);
     Nan::SetPrototypeMethod(local_function_template, "fileAst",             fileAst);
@@ -65,6 +974,18 @@ void node_tool::Init(Handle<Object> target) {
     Nan::SetPrototypeMethod(local_function_template, "cursorTypeAt",        cursorTypeAt);
     Nan::SetPrototypeMethod(local_function_template, "cursorDeclarationAt", cursorDeclarationAt);
     Nan::SetPrototypeMethod(local_function_template, "cursorDefinitionAt",  cursorDefinitionAt);
+    Nan::SetPrototypeMethod(local_function_template, "cursorInfoAt",        cursorInfoAt);
+    Nan::SetPrototypeMethod(local_function_template, "cursorInfoBatch",     cursorInfoBatch);
+    Nan::SetPrototypeMethod(local_function_template, "cursorEnclosingFunctionAt", cursorEnclosingFunctionAt);
+    Nan::SetPrototypeMethod(local_function_template, "signatureHelpAt",     signatureHelpAt);
+    Nan::SetPrototypeMethod(local_function_template, "indexPin",            indexPin);
+    Nan::SetPrototypeMethod(local_function_template, "indexUnpin",          indexUnpin);
+    Nan::SetPrototypeMethod(local_function_template, "setVirtualFileOverlay", setVirtualFileOverlay);
+    Nan::SetPrototypeMethod(local_function_template, "loadCompilationDatabase", loadCompilationDatabase);
+    Nan::SetPrototypeMethod(local_function_template, "setFileArgs",         setFileArgs);
+    Nan::SetPrototypeMethod(local_function_template, "setConfiguration",    setConfiguration);
+    Nan::SetPrototypeMethod(local_function_template, "useConfiguration",    useConfiguration);
+    Nan::SetPrototypeMethod(local_function_template, "setMemoryBudget",     setMemoryBudget);
 
     // Add constructor to our addon
     target->Set(Nan::New("object").ToLocalChecked(), local_function_template->GetFunction());
@@ -114,6 +1035,31 @@ void node_tool::Init(Handle<Object> target) {
 
     Nan::Set(target, Nan::New<String>("unkown_t").ToLocalChecked(),
         Nan::New<Number>(static_cast<uint32_t>(clang::completion_type::unkown_t)));
+
+    // Add the completion contexts most useful for filtering, see CXCompletionContext
+    Nan::Set(target, Nan::New<String>("context_any_type").ToLocalChecked(),
+        Nan::New<Number>(static_cast<double>(CXCompletionContext_AnyType)));
+
+    Nan::Set(target, Nan::New<String>("context_any_value").ToLocalChecked(),
+        Nan::New<Number>(static_cast<double>(CXCompletionContext_AnyValue)));
+
+    Nan::Set(target, Nan::New<String>("context_dot_member").ToLocalChecked(),
+        Nan::New<Number>(static_cast<double>(CXCompletionContext_DotMemberAccess)));
+
+    Nan::Set(target, Nan::New<String>("context_arrow_member").ToLocalChecked(),
+        Nan::New<Number>(static_cast<double>(CXCompletionContext_ArrowMemberAccess)));
+
+    Nan::Set(target, Nan::New<String>("context_namespace").ToLocalChecked(),
+        Nan::New<Number>(static_cast<double>(CXCompletionContext_Namespace)));
+
+    Nan::Set(target, Nan::New<String>("context_nested_name").ToLocalChecked(),
+        Nan::New<Number>(static_cast<double>(CXCompletionContext_NestedNameSpecifier)));
+
+    Nan::Set(target, Nan::New<String>("context_macro_name").ToLocalChecked(),
+        Nan::New<Number>(static_cast<double>(CXCompletionContext_MacroName)));
+
+    Nan::Set(target, Nan::New<String>("context_natural_language").ToLocalChecked(),
+        Nan::New<Number>(static_cast<double>(CXCompletionContext_NaturalLanguage)));
 }
 
 /// set arguments
@@ -127,49 +1073,239 @@ NAN_METHOD(node_tool::setArgs) {
     // get arguments and relay to node_tool
     Local<Array> arr = Local<Array>::Cast(info[0]);
     std::vector<std::string> args2;
-    std::vector<const char*> args2_pointers(arr->Length());
 
-    // copy the node array to args2
-    for (std::size_t i = 0; i < arr->Length(); ++i) {
-        String::Utf8Value str(arr->Get(i));;
-        args2.push_back( *str );
-    }
+    // copy the node array to args2
+    for (std::size_t i = 0; i < arr->Length(); ++i) {
+        String::Utf8Value str(arr->Get(i));;
+        args2.push_back( *str );
+    }
+
+    // clients call this defensively, only reparse if the arguments actually changed
+    std::vector<std::string> normalized = normalize_arguments(args2);
+    if (normalized == instance->args)
+        return;
+
+    // the overlays are appended to whatever is set here
+    instance->args = normalized;
+    instance->apply_args(instance->tool, 0);
+
+    // files with arguments of their own aren't affected
+    for (auto &entry : instance->routes) {
+        if (!entry.second)
+            instance->indexed.erase(entry.first);
+    }
+
+    auto state = instance->parked.find(std::string());
+    if (state != instance->parked.end()) {
+        for (auto &entry : state->second.routes) {
+            if (!entry.second)
+                state->second.indexed.erase(entry.first);
+        }
+    }
+
+    for (auto &entry : instance->pinned) {
+        if (!entry.second.set)
+            instance->rearm(entry.first);
+    }
+
+    // configurations are combined with the new arguments, files using them move
+    for (auto it = instance->combined.begin(); it != instance->combined.end();) {
+        if (it->first.first)
+            ++it;
+        else
+            it = instance->combined.erase(it);
+    }
+
+    instance->retarget();
+    instance->end_sessions();
+    ++instance->epoch;
+
+    return;
+}
+
+/// add / update file
+NAN_METHOD(node_tool::indexTouch) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() < 1 || info.Length() > 2 || !info[0]->IsString()
+        || (info.Length() == 2 && !info[1]->IsBoolean() && !info[1]->IsObject())) {
+        Nan::ThrowError("Usage: indexTouch(String path [, Boolean force | Object options])");
+        return;
+    }
+
+    String::Utf8Value str(info[0]);
+    bool force = false;
+    bool outline = false;
+
+    if (info.Length() == 2 && info[1]->IsObject()) {
+        force = option_bool(Local<Object>::Cast(info[1]), "force", false);
+        outline = option_bool(Local<Object>::Cast(info[1]), "outline", false);
+    } else if (info.Length() == 2) {
+        force = info[1]->BooleanValue();
+    }
+
+    // files that are already parsed in full stay that way
+    bool full = instance->pinned.count(*str) || (instance->indexed.count(*str) && !instance->outlined.count(*str));
+    if (outline && !full)
+        instance->outlined.insert(*str);
+
+    instance->pending.erase(*str);
+    bool dropped = instance->unsaved.erase(*str) != 0;
+
+    // headers only matter to the files including them, there is no need to parse them on their own
+    bool header = !instance->pinned.count(*str) && !instance->indexed.count(*str) && !instance->database.lookup(*str)
+        && !instance->includes.dependents(*str).empty();
+
+    uint32_t generation;
+    if (header) {
+        file_stamp stamp;
+        bool stamped = stamp.read(*str);
+
+        auto last = instance->header_stamps.find(*str);
+        if (!force && stamped && last != instance->header_stamps.end() && last->second == stamp) {
+            info.GetReturnValue().Set(Nan::New<Number>(instance->generation(*str)));
+            return;
+        }
+
+        instance->header_stamps[*str] = stamp;
+
+        // its own includes are updated once a file including it is parsed again
+        generation = instance->touched(*str);
+    } else if (instance->pinned.count(*str)) {
+        generation = instance->touched(*str);
+        instance->reparse(*str);
+    } else if (instance->index(*str, force)) {
+        generation = instance->touched(*str);
+    } else {
+        // unchanged, everything parsed from it is still valid
+        info.GetReturnValue().Set(Nan::New<Number>(instance->generation(*str)));
+        return;
+    }
+
+    // files including a header have to be parsed again as well
+    instance->invalidate(*str, dropped);
+    instance->end_sessions();
+
+    info.GetReturnValue().Set(Nan::New<Number>(generation));
+}
+
+/// add temp contents
+NAN_METHOD(node_tool::indexTouchUnsaved) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() < 2 || info.Length() > 3 || !info[0]->IsString() || !is_content(info[1])
+        || (info.Length() == 3 && !info[2]->IsObject())) {
+        Nan::ThrowError("Usage: indexTouchUnsaved(String path, String|Buffer content [, Object cursor])");
+        return;
+    }
+
+    String::Utf8Value pStr(info[0]);
+    text_buffer& buffer = instance->unsaved[*pStr];
+    read_content(info[1], buffer);
+
+    instance->pending.insert(*pStr);
+    uint32_t generation = instance->touched(*pStr);
+
+    instance->flush(*pStr);
+
+    bool pinned = instance->pinned.count(*pStr);
+
+    // start completing right away if the cursor is behind a member access,
+    // pinned files would complete against the previous snapshot
+    if (info.Length() == 3 && !pinned && instance->tool_for(*pStr).contains(*pStr)) {
+        Local<Object> cursor = Local<Object>::Cast(info[2]);
+        Local<Value> row = Nan::Get(cursor, Nan::New<String>("row").ToLocalChecked()).ToLocalChecked();
+        Local<Value> col = Nan::Get(cursor, Nan::New<String>("col").ToLocalChecked()).ToLocalChecked();
 
-    // copy args2 to args2_pointer
-    struct c_str { const char* operator ()(const std::string& s) { return s.c_str(); } };
-    std::transform(args2.begin(), args2.end(), args2_pointers.begin(), c_str());
+        if (row->IsNumber() && col->IsNumber()
+            && completion_trigger(buffer.view().c_str(), buffer.size(), row->Uint32Value(), col->Uint32Value()))
+        {
+            instance->prewarmed.clear();
+            Nan::AsyncQueueWorker(new prewarm_worker(instance, *pStr, row->Uint32Value(), col->Uint32Value()));
+        }
+    }
 
-    // arguments set copies it so letting it go out of scope is fine
-    instance->tool.arguments_set(&args2_pointers[0], args2_pointers.size());
-    return;
+    info.GetReturnValue().Set(Nan::New<Number>(generation));
 }
 
-/// add / update file
-NAN_METHOD(node_tool::indexTouch) {
+/// incremental changes
+NAN_METHOD(node_tool::indexApplyEdits) {
     node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
 
+    const char* usage = "Usage: indexApplyEdits(String path, Array edits)";
+
     // make sure the syntax is correct
-    if (info.Length() != 1 || !info[0]->IsString())
-      Nan::ThrowError("Usage: indexTouch(String path)");
+    if (info.Length() != 2 || !info[0]->IsString() || !info[1]->IsArray()) {
+        Nan::ThrowError(usage);
+        return;
+    }
+
+    struct edit {
+        uint32_t start_row, start_col;
+        uint32_t end_row, end_col;
+        std::string text;
+    };
+
+    // validate everything before the buffer is modified
+    Local<Array> arr = Local<Array>::Cast(info[1]);
+    std::vector<edit> edits(arr->Length());
+    for (uint32_t i = 0; i < arr->Length(); ++i) {
+        Local<Value> v = arr->Get(i);
+        if (!v->IsObject()) {
+            Nan::ThrowError(usage);
+            return;
+        }
+
+        Local<Object> obj = Local<Object>::Cast(v);
+        Local<Value> range = Nan::Get(obj, Nan::New<String>("range").ToLocalChecked()).ToLocalChecked();
+        Local<Value> text = Nan::Get(obj, Nan::New<String>("text").ToLocalChecked()).ToLocalChecked();
+        if (!range->IsObject() || !text->IsString()) {
+            Nan::ThrowError(usage);
+            return;
+        }
+
+        Local<Object> r = Local<Object>::Cast(range);
+        if (!option_position(Nan::Get(r, Nan::New<String>("start").ToLocalChecked()).ToLocalChecked(),
+                edits[i].start_row, edits[i].start_col)
+            || !option_position(Nan::Get(r, Nan::New<String>("end").ToLocalChecked()).ToLocalChecked(),
+                edits[i].end_row, edits[i].end_col))
+        {
+            Nan::ThrowError(usage);
+            return;
+        }
+
+        String::Utf8Value tStr(text);
+        edits[i].text.assign(*tStr, tStr.length());
+    }
 
     String::Utf8Value str(info[0]);
-    instance->tool.index_touch(*str);
-    return;
-}
 
-/// add temp contents
-NAN_METHOD(node_tool::indexTouchUnsaved) {
-    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+    // edits are relative to the on-disk content until the file has unsaved content
+    auto it = instance->unsaved.find(*str);
+    if (it == instance->unsaved.end()) {
+        std::string disk;
+        if (!instance->content(*str, disk)) {
+            Nan::ThrowError("Unable to read file");
+            return;
+        }
 
-    // make sure the syntax is correct
-    if (info.Length() != 2 || !info[0]->IsString() || !info[1]->IsString())
-        Nan::ThrowError("Usage: indexTouchTemp(String path, String content)");
+        it = instance->unsaved.insert(std::make_pair(std::string(*str), text_buffer())).first;
+        it->second.assign(disk);
+    }
 
-    String::Utf8Value pStr(info[0]);
-    String::Utf8Value vStr(info[1]);
+    // each edit applies to the result of the previous one
+    text_buffer& buffer = it->second;
+    for (auto &e : edits) {
+        std::size_t begin = buffer.offset(e.start_row, e.start_col);
+        std::size_t end = buffer.offset(e.end_row, e.end_col);
+        buffer.replace(begin, end, e.text.c_str(), e.text.size());
+    }
 
-    instance->tool.index_touch_unsaved(*pStr, *vStr, vStr.length());
-    return;
+    // the buffer is only made contiguous once clang needs it
+    instance->pending.insert(*str);
+    info.GetReturnValue().Set(Nan::New<Number>(instance->touched(*str)));
 }
 
 /// memory usage
@@ -177,13 +1313,38 @@ NAN_METHOD(node_tool::indexStatus) {
     node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
 
     Local<Array> ret = Nan::New<Array>();
-    auto stat = instance->tool.index_status();
-
     uint32_t i = 0;
-    for (auto &entry : stat) {
+
+    // the shared index and one per argument set of the compilation database
+    std::vector<unit_cache*> shared(1, &instance->tool);
+    for (auto &entry : instance->tools)
+        shared.push_back(entry.second.get());
+
+    for (auto t : shared) {
+        for (auto &entry : t->index_status()) {
+            Local<Array> e = Nan::New<Array>();
+            Nan::Set(e, Nan::New(0), Nan::New<String>(entry.first.c_str()).ToLocalChecked());
+            Nan::Set(e, Nan::New(1), Nan::New<Number>(entry.second));
+            Nan::Set(ret, i++, e);
+        }
+    }
+
+    // pinned files count both buffers, back can't be inspected while it is reparsed so assume it matches front
+    for (auto &entry : instance->pinned) {
+        double usage = 0;
+        for (auto &s : entry.second.front->index_status())
+            usage += s.second;
+
+        if (entry.second.busy) {
+            usage *= 2;
+        } else {
+            for (auto &s : entry.second.back->index_status())
+                usage += s.second;
+        }
+
         Local<Array> e = Nan::New<Array>();
         Nan::Set(e, Nan::New(0), Nan::New<String>(entry.first.c_str()).ToLocalChecked());
-        Nan::Set(e, Nan::New(1), Nan::New<Number>(entry.second[CXTUResourceUsage_Combined]));
+        Nan::Set(e, Nan::New(1), Nan::New<Number>(usage));
         Nan::Set(ret, i++, e);
     }
 
@@ -200,11 +1361,49 @@ NAN_METHOD(node_tool::indexClear) {
 
     if (info.Length()) {
         String::Utf8Value str(info[0]);
-        instance->tool.index_remove(*str);
+        instance->pending.erase(*str);
+        instance->indexed.erase(*str);
+        instance->outlined.erase(*str);
+        instance->header_stamps.erase(*str);
+        instance->stale.erase(*str);
+        instance->includes.remove(*str);
+        instance->pinned.erase(*str);
+        instance->unchecked.erase(*str);
+        instance->tool_for(*str).index_remove(*str);
+        instance->routes.erase(*str);
+
+        for (auto &state : instance->parked) {
+            auto r = state.second.routes.find(*str);
+            if (r == state.second.routes.end())
+                continue;
+
+            instance->drop(*str, r->second);
+            state.second.routes.erase(r);
+            state.second.indexed.erase(*str);
+        }
+
+        // the files including it go back to the content on disk
+        if (instance->unsaved.erase(*str))
+            instance->invalidate(*str, true);
     } else {
+        instance->pending.clear();
+        instance->unsaved.clear();
+        instance->indexed.clear();
+        instance->outlined.clear();
+        instance->header_stamps.clear();
+        instance->stale.clear();
+        instance->includes.clear();
+        instance->pinned.clear();
         instance->tool.index_clear();
+        instance->tools.clear();
+        instance->routes.clear();
+        instance->parked.clear();
+        instance->unchecked.clear();
     }
 
+    instance->end_sessions();
+    ++instance->epoch;
+
     return;
 }
 
@@ -213,11 +1412,22 @@ NAN_METHOD(node_tool::fileAst) {
     node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
 
      // make sure the syntax is correct
-    if (info.Length() != 1 || !info[0]->IsString())
-        Nan::ThrowError("Usage: fileAst(String path)");
+    if (info.Length() < 1 || info.Length() > 2 || !info[0]->IsString()
+        || (info.Length() == 2 && !info[1]->IsNumber() && !info[1]->IsObject())) {
+        Nan::ThrowError("Usage: fileAst(String path [, Number generation | Object options])");
+        return;
+    }
 
     String::Utf8Value str(info[0]);
-    auto ast = instance->tool.tu_ast(*str);
+    Local<Value> min = info[1]->IsObject() ? option_value(Local<Object>::Cast(info[1]), "generation") : info[1];
+    if (!instance->configure(info[1]) || !instance->reached(*str, min))
+        return;
+
+    instance->flush(*str);
+    if (!instance->known(*str))
+        return;
+
+    auto ast = instance->tool_for(*str).tu_ast(*str);
 
     std::function<void(clang::ast_element*, Local<Object>)> astVisitor;
     astVisitor = [&](clang::ast_element *e, Local<Object> o) {
@@ -247,6 +1457,7 @@ NAN_METHOD(node_tool::fileAst) {
 
     Local<Object> ret = Nan::New<Object>();
     astVisitor(&ast, ret);
+    set_generation(ret, instance->served(*str));
 
     info.GetReturnValue().Set(ret);
 }
@@ -256,11 +1467,22 @@ NAN_METHOD(node_tool::fileDiagnose) {
     node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
 
     // make sure the syntax is correct
-    if (info.Length() != 1 || !info[0]->IsString())
-        Nan::ThrowError("Usage: fileDiagnose(String path)");
+    if (info.Length() < 1 || info.Length() > 2 || !info[0]->IsString()
+        || (info.Length() == 2 && !info[1]->IsNumber() && !info[1]->IsObject())) {
+        Nan::ThrowError("Usage: fileDiagnose(String path [, Number generation | Object options])");
+        return;
+    }
 
     String::Utf8Value str(info[0]);
-    auto diag = instance->tool.tu_diagnose(*str);
+    Local<Value> min = info[1]->IsObject() ? option_value(Local<Object>::Cast(info[1]), "generation") : info[1];
+    if (!instance->configure(info[1]) || !instance->reached(*str, min))
+        return;
+
+    instance->flush(*str);
+    if (!instance->known(*str))
+        return;
+
+    auto diag = instance->tool_for(*str).tu_diagnose(*str);
 
     // Convert obj to ret
     Local<Array> ret = Nan::New<Array>();
@@ -277,6 +1499,7 @@ NAN_METHOD(node_tool::fileDiagnose) {
         Nan::Set(ret, i++, e);
     }
 
+    set_generation(ret, instance->served(*str));
     info.GetReturnValue().Set(ret);
 }
 
@@ -285,35 +1508,116 @@ NAN_METHOD(node_tool::cursorCandidatesAt) {
     node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
 
     // make sure the syntax is correct
-    if (info.Length() != 3 || !info[0]->IsString() || !info[1]->IsNumber() || !info[2]->IsNumber())
-        Nan::ThrowError("Usage: cursorCandidatesAt(String path, Number row, Number column)");
+    if (info.Length() < 3 || info.Length() > 4 || !info[0]->IsString() || !info[1]->IsNumber() || !info[2]->IsNumber()
+        || (info.Length() == 4 && !info[3]->IsObject())) {
+        Nan::ThrowError("Usage: cursorCandidatesAt(String path, Number row, Number column [, Object options])");
+        return;
+    }
 
     String::Utf8Value str(info[0]);
     auto row = info[1]->ToNumber();
     auto col = info[2]->ToNumber();
 
-    // get completion results
-    Local<Array> ret = Nan::New<Array>();
-    auto comp = instance->tool.cursor_complete(*str, row->Value(), col->Value());
-
-    uint32_t j = 0;
-    for (auto &candidate : comp) {
-        Local<Object> entry = Nan::New<Object>();
-        Local<Array> info = Nan::New<Array>();
-        Nan::Set(entry, Nan::New<String>("name").ToLocalChecked(), Nan::New<String>(candidate.name.c_str()).ToLocalChecked());
-        Nan::Set(entry, Nan::New<String>("return_type").ToLocalChecked(), Nan::New<String>(candidate.return_type.c_str()).ToLocalChecked());
-        Nan::Set(entry, Nan::New<String>("type").ToLocalChecked(), Nan::New<Number>(static_cast<uint32_t>(candidate.type)));
-        Nan::Set(entry, Nan::New<String>("brief").ToLocalChecked(), Nan::New<String>(candidate.brief.c_str()).ToLocalChecked());
-        Nan::Set(entry, Nan::New<String>("priority").ToLocalChecked(), Nan::New<Number>(candidate.priority));
+    completion_options opts;
+    Local<Value> content = Nan::Undefined();
+
+    if (info.Length() == 4) {
+        Local<Object> obj = Local<Object>::Cast(info[3]);
+        opts = option_completion(obj);
+        content = option_value(obj, "content");
+
+        if (!instance->configure(obj))
+            return;
+
+        // content passed along is a new generation itself
+        if (is_content(content))
+            instance->touched(*str);
+
+        if (!instance->reached(*str, option_value(obj, "generation")))
+            return;
+    }
+
+    // complete at the start of the token so the results can be reused while it is typed
+    uint32_t start = col->Value();
+    if (opts.filter.size() < start)
+        start -= opts.filter.size();
+
+    // prewarms request what the editor asked for last
+    instance->completion_flags = opts.flags();
+
+    // pick up results computed in the background
+    if (instance->prewarmed.matches(*str, row->Value(), start, opts.filter, opts.flags())) {
+        instance->session = instance->prewarmed;
+        instance->prewarmed.clear();
+    }
+
+    // the candidates of a session don't depend on the text typed since, parse it once something else needs it
+    if (is_content(content)) {
+        read_content(content, instance->unsaved[*str]);
+        instance->pending.insert(*str);
+    }
 
-        for (uint32_t i = 0; i < candidate.args.size(); ++i) {
-            Nan::Set(info, i, Nan::New<String>(candidate.args[i].c_str()).ToLocalChecked());
+    if (!instance->session.matches(*str, row->Value(), start, opts.filter, opts.flags())) {
+        unsigned long long contexts = 0;
+        instance->flush_includes(*str);
+        instance->outlined.erase(*str);
+
+        if (instance->deferred(*str)) {
+            // clang reparses for completion anyway, the unit catches up the next time the file is queried
+            const std::string& buf = instance->unsaved[*str].view();
+            instance->session.candidates = instance->tool_for(*str).cursor_complete(*str, row->Value(), start,
+                opts.flags(), &contexts, buf.data(), buf.size());
+        } else {
+            instance->flush(*str);
+            if (!instance->known(*str))
+                return;
+
+            // pinned files answer from the previous snapshot, complete against the latest content instead
+            const char* data = nullptr;
+            std::size_t length = 0;
+            auto buf = instance->unsaved.find(*str);
+            if (instance->pinned.count(*str) && buf != instance->unsaved.end()) {
+                data = buf->second.view().data();
+                length = buf->second.size();
+            }
+
+            instance->session.candidates = instance->tool_for(*str).cursor_complete(*str, row->Value(), start,
+                opts.flags(), &contexts, data, length);
         }
 
-        Nan::Set(entry, Nan::New<String>("info").ToLocalChecked(), info);
-        Nan::Set(ret, j++, entry);
+        instance->session.path = *str;
+        instance->session.row = row->Value();
+        instance->session.col = start;
+        instance->session.filter = opts.filter;
+        instance->session.flags = opts.flags();
+        instance->session.contexts = contexts;
+    }
+
+    // filter and rank before anything is converted
+    std::vector<const completion_candidate*> selected;
+    uint32_t total = 0;
+    if (opts.accepts_contexts(instance->session.contexts))
+        total = completion_select(instance->session.candidates, opts, selected);
+
+    Local<Number> contexts = Nan::New<Number>(static_cast<double>(instance->session.contexts));
+
+    if (opts.binary) {
+        std::string buf = completion_encode(selected, total, opts);
+        Local<Object> ret = Nan::CopyBuffer(buf.data(), buf.size()).ToLocalChecked();
+        Nan::Set(ret, Nan::New<String>("contexts").ToLocalChecked(), contexts);
+        set_generation(ret, instance->served(*str));
+        info.GetReturnValue().Set(ret);
+        return;
+    }
+
+    Local<Array> ret = Nan::New<Array>();
+    for (uint32_t j = 0; j < selected.size(); ++j) {
+        Nan::Set(ret, j, completion_object(*selected[j], opts));
     }
 
+    Nan::Set(ret, Nan::New<String>("total").ToLocalChecked(), Nan::New<Number>(total));
+    Nan::Set(ret, Nan::New<String>("contexts").ToLocalChecked(), contexts);
+    set_generation(ret, instance->served(*str));
     info.GetReturnValue().Set(ret);
 }
 
@@ -322,15 +1626,23 @@ NAN_METHOD(node_tool::cursorTypeAt) {
     node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
 
     // make sure the syntax is correct
-    if (info.Length() != 3 || !info[0]->IsString() || !info[1]->IsNumber() || !info[2]->IsNumber())
-        Nan::ThrowError("Usage: cursorTypeAt(String path, Number row, Number column)");
+    if (info.Length() < 3 || info.Length() > 4 || !info[0]->IsString() || !info[1]->IsNumber() || !info[2]->IsNumber()
+        || (info.Length() == 4 && !info[3]->IsObject()))
+        Nan::ThrowError("Usage: cursorTypeAt(String path, Number row, Number column [, Object options])");
 
     String::Utf8Value str(info[0]);
     auto row = info[1]->ToNumber();
     auto col = info[2]->ToNumber();
 
+    if (!instance->configure(info[3]))
+        return;
+
+    instance->flush(*str);
+    if (!instance->known(*str))
+        return;
+
     info.GetReturnValue().Set(
-        Nan::New<String>(instance->tool.cursor_type(*str, row->Value(), col->Value()).c_str()).ToLocalChecked()
+        Nan::New<String>(instance->tool_for(*str).cursor_type(*str, row->Value(), col->Value()).c_str()).ToLocalChecked()
     );
 }
 
@@ -339,20 +1651,24 @@ NAN_METHOD(node_tool::cursorDeclarationAt) {
     node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
 
     // make sure the syntax is correct
-    if (info.Length() != 3 || !info[0]->IsString() || !info[1]->IsNumber() || !info[2]->IsNumber())
-        Nan::ThrowError("Usage: cursorTypeAt(String path, Number row, Number column)");
+    if (info.Length() < 3 || info.Length() > 4 || !info[0]->IsString() || !info[1]->IsNumber() || !info[2]->IsNumber()
+        || (info.Length() == 4 && !info[3]->IsObject()))
+        Nan::ThrowError("Usage: cursorTypeAt(String path, Number row, Number column [, Object options])");
 
     String::Utf8Value str(info[0]);
     auto row = info[1]->ToNumber();
     auto col = info[2]->ToNumber();
 
-    auto loc = instance->tool.cursor_declaration(*str, row->Value(), col->Value());
+    if (!instance->configure(info[3]))
+        return;
 
-    Local<Object> ret = Nan::New<Object>();
-    Nan::Set(ret, Nan::New<String>("file").ToLocalChecked(), Nan::New<String>(loc.file.c_str()).ToLocalChecked());
-    Nan::Set(ret, Nan::New<String>("row").ToLocalChecked(), Nan::New<Number>(loc.row));
-    Nan::Set(ret, Nan::New<String>("col").ToLocalChecked(), Nan::New<Number>(loc.col));
+    instance->flush(*str);
+    if (!instance->known(*str))
+        return;
 
+    auto e = instance->tool_for(*str).cursor_info(*str, row->Value(), col->Value(), cursor_field_declaration);
+    Local<Object> ret = location_object(e.declaration);
+    set_generation(ret, instance->served(*str));
     info.GetReturnValue().Set(ret);
 }
 
@@ -361,23 +1677,520 @@ NAN_METHOD(node_tool::cursorDefinitionAt) {
     node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
 
     // make sure the syntax is correct
-    if (info.Length() != 3 || !info[0]->IsString() || !info[1]->IsNumber() || !info[2]->IsNumber())
-        Nan::ThrowError("Usage: cursorTypeAt(String path, Number row, Number column)");
+    if (info.Length() < 3 || info.Length() > 4 || !info[0]->IsString() || !info[1]->IsNumber() || !info[2]->IsNumber()
+        || (info.Length() == 4 && !info[3]->IsObject()))
+        Nan::ThrowError("Usage: cursorTypeAt(String path, Number row, Number column [, Object options])");
+
+    String::Utf8Value str(info[0]);
+    auto row = info[1]->ToNumber();
+    auto col = info[2]->ToNumber();
+
+    if (!instance->configure(info[3]))
+        return;
+
+    instance->flush(*str);
+    if (!instance->known(*str))
+        return;
+
+    auto e = instance->tool_for(*str).cursor_info(*str, row->Value(), col->Value(), cursor_field_definition);
+    Local<Object> ret = location_object(e.definition);
+    set_generation(ret, instance->served(*str));
+    info.GetReturnValue().Set(ret);
+}
+
+/// type, declaration and definition for pos
+NAN_METHOD(node_tool::cursorInfoAt) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() < 3 || info.Length() > 4 || !info[0]->IsString() || !info[1]->IsNumber() || !info[2]->IsNumber()
+        || (info.Length() == 4 && !info[3]->IsObject())) {
+        Nan::ThrowError("Usage: cursorInfoAt(String path, Number row, Number column [, Object fields])");
+        return;
+    }
 
     String::Utf8Value str(info[0]);
     auto row = info[1]->ToNumber();
     auto col = info[2]->ToNumber();
 
-    auto loc = instance->tool.cursor_definition(*str, row->Value(), col->Value());
+    uint32_t fields = cursor_field_default;
+    if (info.Length() == 4) {
+        fields = option_cursor_fields(Local<Object>::Cast(info[3]));
 
+        if (!instance->configure(info[3]) || !instance->reached(*str, option_value(Local<Object>::Cast(info[3]), "generation")))
+            return;
+    }
+
+    instance->flush(*str);
+    if (!instance->known(*str))
+        return;
+
+    auto e = instance->tool_for(*str).cursor_info(*str, row->Value(), col->Value(), fields);
     Local<Object> ret = Nan::New<Object>();
-    Nan::Set(ret, Nan::New<String>("file").ToLocalChecked(), Nan::New<String>(loc.file.c_str()).ToLocalChecked());
-    Nan::Set(ret, Nan::New<String>("row").ToLocalChecked(), Nan::New<Number>(loc.row));
-    Nan::Set(ret, Nan::New<String>("col").ToLocalChecked(), Nan::New<Number>(loc.col));
+
+    if (fields & cursor_field_type)
+        Nan::Set(ret, Nan::New<String>("type").ToLocalChecked(), Nan::New<String>(e.type.c_str()).ToLocalChecked());
+    if (fields & cursor_field_declaration)
+        Nan::Set(ret, Nan::New<String>("declaration").ToLocalChecked(), location_object(e.declaration));
+    if (fields & cursor_field_definition)
+        Nan::Set(ret, Nan::New<String>("definition").ToLocalChecked(), location_object(e.definition));
+
+    if (fields & cursor_field_docs) {
+        Local<Object> docs = Nan::New<Object>();
+        Nan::Set(docs, Nan::New<String>("brief").ToLocalChecked(), Nan::New<String>(e.brief.c_str()).ToLocalChecked());
+        Nan::Set(docs, Nan::New<String>("comment").ToLocalChecked(), Nan::New<String>(e.comment.c_str()).ToLocalChecked());
+        Nan::Set(ret, Nan::New<String>("docs").ToLocalChecked(), docs);
+    }
+
+    set_generation(ret, instance->served(*str));
+
+    info.GetReturnValue().Set(ret);
+}
+
+/// cursorInfoAt for many positions
+NAN_METHOD(node_tool::cursorInfoBatch) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() < 2 || info.Length() > 3 || !info[0]->IsString() || !info[1]->IsInt32Array()
+        || (info.Length() == 3 && !info[2]->IsObject())) {
+        Nan::ThrowError("Usage: cursorInfoBatch(String path, Int32Array positions [, Object fields])");
+        return;
+    }
+
+    String::Utf8Value str(info[0]);
+    Nan::TypedArrayContents<int32_t> positions(info[1]);
+
+    uint32_t fields = cursor_field_default;
+    if (info.Length() == 3) {
+        fields = option_cursor_fields(Local<Object>::Cast(info[2]));
+
+        if (!instance->configure(info[2]) || !instance->reached(*str, option_value(Local<Object>::Cast(info[2]), "generation")))
+            return;
+    }
+
+    instance->flush(*str);
+    if (!instance->known(*str))
+        return;
+
+    // types, file names and comments repeat a lot, store each once
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, int32_t> string_index;
+    auto intern = [&](const std::string& s) -> int32_t {
+        auto it = string_index.find(s);
+        if (it != string_index.end())
+            return it->second;
+
+        int32_t id = strings.size();
+        string_index.emplace(s, id);
+        strings.push_back(s);
+        return id;
+    };
+
+    std::size_t count = positions.length() / 2;
+    std::vector<int32_t> types, declarations, definitions, docs;
+    types.reserve(fields & cursor_field_type ? count : 0);
+    declarations.reserve(fields & cursor_field_declaration ? count * 3 : 0);
+    definitions.reserve(fields & cursor_field_definition ? count * 3 : 0);
+    docs.reserve(fields & cursor_field_docs ? count * 2 : 0);
+
+    // the unit is looked up once, each position is a binary search in its cursor extents
+    std::shared_ptr<translation_unit> unit = instance->tool_for(*str).unit(*str);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        uint32_t row = (*positions)[i * 2];
+        uint32_t col = (*positions)[i * 2 + 1];
+        auto e = unit->cursor_info(row, col, fields);
+
+        if (fields & cursor_field_type)
+            types.push_back(intern(e.type));
+
+        if (fields & cursor_field_declaration) {
+            declarations.push_back(intern(e.declaration.file));
+            declarations.push_back(e.declaration.row);
+            declarations.push_back(e.declaration.col);
+        }
+
+        if (fields & cursor_field_definition) {
+            definitions.push_back(intern(e.definition.file));
+            definitions.push_back(e.definition.row);
+            definitions.push_back(e.definition.col);
+        }
+
+        if (fields & cursor_field_docs) {
+            docs.push_back(intern(e.brief));
+            docs.push_back(intern(e.comment));
+        }
+    }
+
+    Local<Array> table = Nan::New<Array>();
+    for (uint32_t i = 0; i < strings.size(); ++i) {
+        Nan::Set(table, i, Nan::New<String>(strings[i].c_str()).ToLocalChecked());
+    }
+
+    Local<Object> ret = Nan::New<Object>();
+    Nan::Set(ret, Nan::New<String>("strings").ToLocalChecked(), table);
+    set_generation(ret, instance->served(*str));
+
+    if (fields & cursor_field_type)
+        Nan::Set(ret, Nan::New<String>("type").ToLocalChecked(), int32_array(types));
+    if (fields & cursor_field_declaration)
+        Nan::Set(ret, Nan::New<String>("declaration").ToLocalChecked(), int32_array(declarations));
+    if (fields & cursor_field_definition)
+        Nan::Set(ret, Nan::New<String>("definition").ToLocalChecked(), int32_array(definitions));
+    if (fields & cursor_field_docs)
+        Nan::Set(ret, Nan::New<String>("docs").ToLocalChecked(), int32_array(docs));
+
+    info.GetReturnValue().Set(ret);
+}
+
+/// function surrounding pos
+NAN_METHOD(node_tool::cursorEnclosingFunctionAt) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() < 3 || info.Length() > 4 || !info[0]->IsString() || !info[1]->IsNumber() || !info[2]->IsNumber()
+        || (info.Length() == 4 && !info[3]->IsObject())) {
+        Nan::ThrowError("Usage: cursorEnclosingFunctionAt(String path, Number row, Number column [, Object options])");
+        return;
+    }
+
+    String::Utf8Value str(info[0]);
+    auto row = info[1]->ToNumber();
+    auto col = info[2]->ToNumber();
+
+    if (!instance->configure(info[3]))
+        return;
+
+    instance->flush(*str);
+    if (!instance->known(*str))
+        return;
+
+    function_scope scope = instance->tool_for(*str).enclosing_function(*str, row->Value(), col->Value());
+    if (!scope.found) {
+        info.GetReturnValue().Set(Nan::Null());
+        return;
+    }
+
+    Local<Object> ret = Nan::New<Object>();
+    Nan::Set(ret, Nan::New<String>("name").ToLocalChecked(), Nan::New<String>(scope.name.c_str()).ToLocalChecked());
+    Nan::Set(ret, Nan::New<String>("begin").ToLocalChecked(), location_object(scope.begin));
+    Nan::Set(ret, Nan::New<String>("end").ToLocalChecked(), location_object(scope.end));
+    set_generation(ret, instance->served(*str));
+    info.GetReturnValue().Set(ret);
+}
+
+/// overloads for the call at pos
+NAN_METHOD(node_tool::signatureHelpAt) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() < 3 || info.Length() > 4 || !info[0]->IsString() || !info[1]->IsNumber() || !info[2]->IsNumber()
+        || (info.Length() == 4 && !info[3]->IsObject())) {
+        Nan::ThrowError("Usage: signatureHelpAt(String path, Number row, Number column [, Object options])");
+        return;
+    }
+
+    String::Utf8Value str(info[0]);
+    auto row = info[1]->ToNumber();
+    auto col = info[2]->ToNumber();
+
+    if (!instance->configure(info[3]))
+        return;
+
+    // unsaved content is scanned in place
+    std::string disk;
+    auto it = instance->unsaved.find(*str);
+    if (it == instance->unsaved.end() && !instance->content(*str, disk)) {
+        Nan::ThrowError("signatureHelpAt: Unable to read file");
+        return;
+    }
+
+    const std::string& content = it == instance->unsaved.end() ? disk : it->second.view();
+
+    // not inside an argument list
+    call_site site = call_site_at(content.c_str(), content.size(), row->Value(), col->Value());
+    if (!site.found) {
+        info.GetReturnValue().Set(Nan::Null());
+        return;
+    }
+
+    // only ask clang when the cursor moved to a different call
+    if (!instance->signatures.matches(*str, site)) {
+        instance->flush(*str);
+        if (!instance->known(*str))
+            return;
+
+        instance->outlined.erase(*str);
+
+        // overloads don't need macros, code patterns or any of the other candidates' extras
+        unit_cache& t = instance->tool_for(*str);
+        unsigned flags = CXCodeComplete_IncludeBriefComments;
+        bool found = instance->signatures.assign(*str, site,
+            t.cursor_complete(*str, site.arg_row, site.arg_col, flags, nullptr));
+
+        // the last comma separated template arguments after all, e.g. foo(std::map<int,
+        if (!found && (site.outer_row != site.arg_row || site.outer_col != site.arg_col))
+            instance->signatures.assign(*str, site, t.cursor_complete(*str, site.outer_row, site.outer_col, flags, nullptr));
+    }
+
+    Local<Array> signatures = Nan::New<Array>();
+    completion_options opts;
+
+    uint32_t i = 0;
+    for (auto &candidate : instance->signatures.signatures) {
+        Local<Object> entry = completion_object(candidate, opts);
+        Nan::Set(entry, Nan::New<String>("label").ToLocalChecked(), Nan::New<String>(candidate.label.c_str()).ToLocalChecked());
+        Nan::Set(signatures, i++, entry);
+    }
+
+    Local<Object> ret = Nan::New<Object>();
+    Nan::Set(ret, Nan::New<String>("name").ToLocalChecked(), Nan::New<String>(site.name.c_str()).ToLocalChecked());
+    Nan::Set(ret, Nan::New<String>("row").ToLocalChecked(), Nan::New<Number>(site.row));
+    Nan::Set(ret, Nan::New<String>("col").ToLocalChecked(), Nan::New<Number>(site.col));
+    Nan::Set(ret, Nan::New<String>("active").ToLocalChecked(), Nan::New<Number>(instance->signatures.active));
+    Nan::Set(ret, Nan::New<String>("signatures").ToLocalChecked(), signatures);
+    set_generation(ret, instance->served(*str));
 
     info.GetReturnValue().Set(ret);
 }
 
+/// pin file
+NAN_METHOD(node_tool::indexPin) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() != 1 || !info[0]->IsString()) {
+        Nan::ThrowError("Usage: indexPin(String path)");
+        return;
+    }
+
+    String::Utf8Value str(info[0]);
+    if (instance->pinned.count(*str))
+        return;
+
+    node_tool::pinned_file file;
+    file.front = std::make_shared<unit_cache>();
+    file.back = std::make_shared<unit_cache>();
+    file.front_generation = instance->generation(*str);
+    file.front_args = instance->args_version;
+    file.back_args = ~instance->args_version;
+    file.set = instance->route(*str);
+    file.busy = false;
+    file.dirty = false;
+    file.renew = false;
+
+    // parse front right away, back follows in the background
+    instance->apply_args(*file.front, file.set);
+    file.front->index_touch(*str, instance->unsaved_snapshot());
+
+    instance->includes.update(*str, file.front->tu_inclusions(*str));
+    instance->pending.erase(*str);
+    instance->outlined.erase(*str);
+    instance->tool_for(*str).index_remove(*str);
+    instance->indexed.erase(*str);
+    instance->routes.erase(*str);
+    instance->pinned[*str] = file;
+    instance->reparse(*str);
+    ++instance->epoch;
+}
+
+/// unpin file
+NAN_METHOD(node_tool::indexUnpin) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() != 1 || !info[0]->IsString()) {
+        Nan::ThrowError("Usage: indexUnpin(String path)");
+        return;
+    }
+
+    String::Utf8Value str(info[0]);
+    if (!instance->pinned.erase(*str))
+        return;
+
+    // back to a single translation unit in the shared index
+    instance->pending.erase(*str);
+    instance->index(*str, true);
+}
+
+/// vfs overlay
+NAN_METHOD(node_tool::setVirtualFileOverlay) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() != 1 || (!info[0]->IsString() && !info[0]->IsObject())) {
+        Nan::ThrowError("Usage: setVirtualFileOverlay(Object mappings | String overlay)");
+        return;
+    }
+
+    uint32_t version = instance->overlay.version();
+    std::string external;
+    std::map<std::string, std::string> files;
+
+    if (info[0]->IsString()) {
+        external = *String::Utf8Value(info[0]);
+    } else {
+        Local<Object> obj = Local<Object>::Cast(info[0]);
+        Local<Array> keys = Nan::GetOwnPropertyNames(obj).ToLocalChecked();
+
+        for (uint32_t i = 0; i < keys->Length(); ++i) {
+            Local<Value> key = keys->Get(i);
+            Local<Value> value = Nan::Get(obj, key).ToLocalChecked();
+            if (!value->IsString()) {
+                Nan::ThrowError("Usage: setVirtualFileOverlay(Object mappings | String overlay)");
+                return;
+            }
+
+            // clang drops relative paths from the overlay without telling
+            std::string virtual_path = *String::Utf8Value(key);
+            std::string real_path = *String::Utf8Value(value);
+            if (virtual_path.empty() || virtual_path[0] != '/' || real_path.empty() || real_path[0] != '/') {
+                Nan::ThrowError(("setVirtualFileOverlay: Paths have to be absolute, got " + virtual_path).c_str());
+                return;
+            }
+
+            files[virtual_path] = real_path;
+        }
+    }
+
+    if (!instance->overlay.remap(files)) {
+        Nan::ThrowError("Unable to write virtual file overlay");
+        return;
+    }
+
+    if (instance->overlay.version() == version && instance->external_overlay == external)
+        return;
+
+    instance->renew();
+    instance->external_overlay = external;
+    instance->args_changed();
+}
+
+/// compile_commands.json
+NAN_METHOD(node_tool::loadCompilationDatabase) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() != 1 || !info[0]->IsString()) {
+        Nan::ThrowError("Usage: loadCompilationDatabase(String directory)");
+        return;
+    }
+
+    String::Utf8Value str(info[0]);
+    if (instance->database.unchanged(*str)) {
+        info.GetReturnValue().Set(Nan::New<Number>(instance->database.size()));
+        return;
+    }
+
+    if (!instance->database.load(*str)) {
+        Nan::ThrowError("Unable to load compilation database");
+        return;
+    }
+
+    // sets keep their number, only files whose arguments changed move
+    instance->retarget();
+    info.GetReturnValue().Set(Nan::New<Number>(instance->database.size()));
+}
+
+/// per-file arguments
+NAN_METHOD(node_tool::setFileArgs) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() < 1 || info.Length() > 2 || !info[0]->IsString()
+        || (info.Length() == 2 && !info[1]->IsArray() && !info[1]->IsNull())) {
+        Nan::ThrowError("Usage: setFileArgs(String path [, Array arguments])");
+        return;
+    }
+
+    String::Utf8Value str(info[0]);
+
+    if (info.Length() == 2 && info[1]->IsArray()) {
+        Local<Array> arr = Local<Array>::Cast(info[1]);
+        std::vector<std::string> args;
+        for (uint32_t i = 0; i < arr->Length(); ++i)
+            args.push_back(*String::Utf8Value(arr->Get(i)));
+
+        instance->database.set_file(*str, args);
+    } else {
+        instance->database.unset_file(*str);
+    }
+
+    // only this file, and headers taking their arguments from it, move
+    instance->retarget();
+}
+
+/// named configuration
+NAN_METHOD(node_tool::setConfiguration) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() != 2 || !info[0]->IsString() || !info[1]->IsArray()) {
+        Nan::ThrowError("Usage: setConfiguration(String name, Array arguments)");
+        return;
+    }
+
+    std::string name = *String::Utf8Value(info[0]);
+    if (name.empty()) {
+        Nan::ThrowError("Configuration name must not be empty");
+        return;
+    }
+
+    Local<Array> arr = Local<Array>::Cast(info[1]);
+    std::vector<std::string> args;
+    for (uint32_t i = 0; i < arr->Length(); ++i)
+        args.push_back(*String::Utf8Value(arr->Get(i)));
+
+    std::vector<std::string> normalized = normalize_arguments(args);
+    auto it = instance->configurations.find(name);
+    if (it != instance->configurations.end() && it->second == normalized)
+        return;
+
+    instance->configurations[name] = normalized;
+    for (auto c = instance->combined.begin(); c != instance->combined.end();) {
+        if (c->first.second == name)
+            c = instance->combined.erase(c);
+        else
+            ++c;
+    }
+
+    // inactive configurations move their files once they are switched to
+    if (instance->configuration == name)
+        instance->retarget();
+}
+
+/// switch configuration
+NAN_METHOD(node_tool::useConfiguration) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() > 1 || (info.Length() == 1 && !info[0]->IsString() && !info[0]->IsNull())) {
+        Nan::ThrowError("Usage: useConfiguration([String name])");
+        return;
+    }
+
+    std::string name;
+    if (info.Length() == 1 && info[0]->IsString())
+        name = *String::Utf8Value(info[0]);
+
+    instance->use_configuration(name);
+}
+
+/// memory budget
+NAN_METHOD(node_tool::setMemoryBudget) {
+    node_tool* instance = Nan::ObjectWrap::Unwrap<node_tool>(info.This());
+
+    // make sure the syntax is correct
+    if (info.Length() != 1 || !info[0]->IsNumber()) {
+        Nan::ThrowError("Usage: setMemoryBudget(Number bytes)");
+        return;
+    }
+
+    instance->budget = info[0]->NumberValue();
+    instance->evict();
+}
+
 /// module initialization
 void initAll(Handle<Object> exports) {
     node_tool::Init(exports);
@@ -23,9 +23,24 @@
 #ifndef _CLANG_TOOL_BINDINGS_HPP_
 #define _CLANG_TOOL_BINDINGS_HPP_
 
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
 #include <nan.h>
 
 #include "clang/clang_tool.hpp"
+#include "compilation_database.hpp"
+#include "completion_filter.hpp"
+#include "content_hash.hpp"
+#include "cursor_index.hpp"
+#include "file_overlay.hpp"
+#include "include_graph.hpp"
+#include "signature_help.hpp"
+#include "text_buffer.hpp"
+#include "unit_cache.hpp"
 
 using namespace v8;
 
@@ -46,6 +61,9 @@ public:
     /** Adds temporary content for specified file on the index, will be purged when using indexTouch */
     static NAN_METHOD(indexTouchUnsaved);
 
+    /** Applies text edits to the unsaved content of the specified file */
+    static NAN_METHOD(indexApplyEdits);
+
     /** Returns current memory usage */
     static NAN_METHOD(indexStatus);
 
@@ -69,6 +87,42 @@ public:
 
     /** Returns where the type under the cursor is defined */
     static NAN_METHOD(cursorDefinitionAt);
+
+    /** Returns type, declaration and definition at given location in one lookup */
+    static NAN_METHOD(cursorInfoAt);
+
+    /** Returns cursorInfoAt results for many locations at once */
+    static NAN_METHOD(cursorInfoBatch);
+
+    /** Returns the function, method or lambda surrounding the cursor */
+    static NAN_METHOD(cursorEnclosingFunctionAt);
+
+    /** Returns the overloads of the call surrounding the cursor */
+    static NAN_METHOD(signatureHelpAt);
+
+    /** Keeps a double-buffered translation unit for the given file */
+    static NAN_METHOD(indexPin);
+
+    /** Moves a pinned file back to the shared index */
+    static NAN_METHOD(indexUnpin);
+
+    /** Maps paths to other files for all translation units */
+    static NAN_METHOD(setVirtualFileOverlay);
+
+    /** Takes per-file arguments from the compile_commands.json in the given directory */
+    static NAN_METHOD(loadCompilationDatabase);
+
+    /** Sets the arguments of a single file */
+    static NAN_METHOD(setFileArgs);
+
+    /** Defines a named set of arguments added to those of every file */
+    static NAN_METHOD(setConfiguration);
+
+    /** Selects the configuration queries are answered for */
+    static NAN_METHOD(useConfiguration);
+
+    /** Limits the memory used by the translation units of inactive configurations */
+    static NAN_METHOD(setMemoryBudget);
 private:
     /** Constructor */
     node_tool();
@@ -78,8 +132,235 @@ private:
     /** Invoked when a new instance is created in NodeJs */
     static NAN_METHOD(New);
 
-    /** Underlying clang-tool instance we are binding */
-    clang::tool tool;
+    /** Hands unsaved content that hasn't been parsed yet to clang before path is queried */
+    void flush(const char* path);
+
+    /** Flushes the edited headers included by path, see flush */
+    void flush_includes(const char* path);
+
+    /** Returns whether the only thing clang is missing about path is its unsaved content */
+    bool deferred(const char* path);
+
+    /** Hands the current content of path to the shared index unless it already has it, returns whether it did */
+    bool index(const char* path, bool force);
+
+    /**
+     * Marks the indexed files including path as stale, pinned ones are reparsed right away. Set renew
+     * if path lost its unsaved content, the units including it are then created from scratch.
+     */
+    void invalidate(const char* path, bool renew = false);
+
+    /** Makes every translation unit read the overlays again with its next parse */
+    void renew();
+
+    /** Returns the unsaved content of every file, see unsaved_files */
+    unsaved_files unsaved_snapshot();
+
+    /** Returns the current content of path, unsaved or from disk */
+    bool content(const char* path, std::string& out);
+
+    /** Advances and returns the generation of path, called whenever new content for it is received */
+    uint32_t touched(const char* path);
+
+    /** Returns the generation of path, 0 if it never was touched */
+    uint32_t generation(const char* path) const;
+
+    /** Throws and returns false if min is a number greater than the generation of path, brings pinned files up to min */
+    bool reached(const char* path, Local<Value> min);
+
+    /** Throws and returns false if path isn't on the index */
+    bool known(const char* path);
+
+    /** Returns the tool that answers queries for path */
+    unit_cache& tool_for(const char* path);
+
+    /** Returns the argument set path should be parsed with, headers use the one of a file including them */
+    uint32_t route(const char* path);
+
+    /** Returns the shared tool for an argument set, 0 is the one configured by setArgs */
+    unit_cache& shared(uint32_t set);
+
+    /** Removes path from the shared tool of a set, sets without one are left alone */
+    void drop(const char* path, uint32_t set);
+
+    /** Returns the generation of the content queries for path are answered from */
+    uint32_t served(const char* path) const;
+
+    /** Returns the arguments of a set plus the ones added by the binding */
+    std::vector<std::string> arguments(uint32_t set) const;
+
+    /** Passes the current arguments of a set to t */
+    void apply_args(unit_cache& t, uint32_t set) const;
+
+    /** Passes the current arguments to every shared tool */
+    void apply_args();
+
+    /** Ends the completion session, drops prewarmed results and cached signatures */
+    void end_sessions();
+
+    /** Applies changed arguments to the shared index and all pinned files */
+    void args_changed();
+
+    /** Moves files whose argument set changed to their new one, returns whether any did */
+    bool retarget();
+
+    /** Drops translation units of inactive configurations, largest first, until the index fits the budget */
+    void evict();
+
+    /** Makes name, empty for none, the active configuration, throws and returns false if it is unknown */
+    bool use_configuration(const std::string& name);
+
+    /** Selects the configuration option of a query's options, throws and returns false if it is unknown */
+    bool configure(Local<Value> options);
+
+    /** Makes a pinned file reparse both buffers with its current arguments */
+    void rearm(const std::string& path);
+
+    /** Starts reparsing the back buffer of a pinned file, or queues it if one is running */
+    void reparse(const std::string& path);
+
+    /** Invoked on the main thread once the back buffer of path has been reparsed */
+    void reparsed(const std::string& path, const std::shared_ptr<unit_cache>& back, uint32_t generation,
+        uint32_t args_version, bool ok);
+
+    /** Translation units of a pinned file, queries use front while back is reparsed */
+    struct pinned_file {
+        /** Last complete translation unit */
+        std::shared_ptr<unit_cache> front;
+        /** Translation unit being reparsed */
+        std::shared_ptr<unit_cache> back;
+        /** Generation of the content front was parsed from */
+        uint32_t front_generation;
+        /** Arguments version front was parsed with */
+        uint32_t front_args;
+        /** Arguments version back was parsed with */
+        uint32_t back_args;
+        /** Argument set both buffers are parsed with */
+        uint32_t set;
+        /** Whether back is being reparsed */
+        bool busy;
+        /** Whether the file changed while back was being reparsed */
+        bool dirty;
+        /** Whether back has to be parsed from scratch, see translation_unit::renew */
+        bool renew;
+    };
+
+    /** Content last handed to the shared index for a file */
+    struct indexed_file {
+        /** Whether it was unsaved content */
+        bool unsaved;
+        /** Stamp of the file on disk, unset for unsaved content */
+        file_stamp stamp;
+        /** Revision of the unsaved content, see text_buffer::revision */
+        uint64_t revision;
+        /** Size of the unsaved content */
+        std::size_t length;
+        /** Hash of the content, only computed once the stamp or the length is all that tells it apart */
+        uint64_t hash;
+        /** Whether hash is set */
+        bool hashed;
+
+        /** Constructor */
+        indexed_file() : unsaved(false), revision(0), length(0), hash(0), hashed(false) {}
+    };
+
+    /** Files and content a configuration was indexed with while another one is active */
+    struct configuration_state {
+        /** Argument set each file is indexed with */
+        std::map<std::string, uint32_t> routes;
+        /** What the shared index was last given for each file */
+        std::map<std::string, indexed_file> indexed;
+    };
+
+    /** Translation units parsed with the arguments given to setArgs */
+    unit_cache tool;
+
+    /** Completion results for the token currently being typed */
+    completion_session session;
+
+    /** Latest unsaved content of each file */
+    std::map<std::string, text_buffer> unsaved;
+
+    /** Files whose unsaved content hasn't been handed to clang yet */
+    std::set<std::string> pending;
+
+    /** What the shared index was last given for each file */
+    std::map<std::string, indexed_file> indexed;
+
+    /** Files parsed without function bodies until they get unsaved content or a completion request */
+    std::set<std::string> outlined;
+
+    /** Stamps of headers that were touched without being parsed on their own */
+    std::map<std::string, file_stamp> header_stamps;
+
+    /** Files whose includes changed since they were parsed */
+    std::set<std::string> stale;
+
+    /** Includes of every indexed file */
+    include_graph includes;
+
+    /** Remapped paths */
+    file_overlay overlay;
+
+    /** Overlay file passed to setVirtualFileOverlay */
+    std::string external_overlay;
+
+    /** Per-file arguments */
+    compilation_database database;
+
+    /** Shared tools of the compilation database, one per argument set */
+    std::map<uint32_t, std::shared_ptr<unit_cache>> tools;
+
+    /** Argument set each file is indexed with */
+    std::map<std::string, uint32_t> routes;
+
+    /** Arguments added by each configuration */
+    std::map<std::string, std::vector<std::string>> configurations;
+
+    /** Active configuration, empty for none */
+    std::string configuration;
+
+    /** State of the inactive configurations, their translation units stay in tools */
+    std::map<std::string, configuration_state> parked;
+
+    /** Argument set of a file's own set combined with a configuration */
+    std::map<std::pair<uint32_t, std::string>, uint32_t> combined;
+
+    /** Files to compare with what the active configuration last parsed, after switching to it */
+    std::set<std::string> unchecked;
+
+    /** Memory budget in bytes for all translation units together, 0 for none */
+    double budget;
+
+    /** Overloads for the call currently being edited */
+    signature_cache signatures;
+
+    /** Generation of each file, never reset */
+    std::map<std::string, uint32_t> generations;
+
+    /** Incremented whenever indexed content or arguments change */
+    uint32_t epoch;
+
+    /** Completion results computed speculatively in the background */
+    completion_session prewarmed;
+
+    /** Incremented whenever a prewarm is queued or the sessions end, results of older prewarms are dropped */
+    uint32_t prewarms;
+
+    /** CXCodeComplete_* flags of the last completion request, prewarms use the same */
+    unsigned completion_flags;
+
+    /** Arguments as set by setArgs */
+    std::vector<std::string> args;
+
+    /** Incremented whenever args change */
+    uint32_t args_version;
+
+    /** Double-buffered files, each costs two translation units */
+    std::map<std::string, pinned_file> pinned;
+
+    friend class prewarm_worker;
+    friend class reparse_worker;
 };
 
 #endif /* _CLANG_TOOL_BINDINGS_HPP_ */
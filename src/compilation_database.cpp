@@ -0,0 +1,560 @@
+/**
+* @file compilation_database.cpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+*/
+
+#include <cstring>
+#include <set>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "compilation_database.hpp"
+#include "content_hash.hpp"
+#include "include_graph.hpp"
+
+/// read-only mapping of a file
+class mapped_file {
+public:
+    mapped_file(const std::string& path) : data(nullptr), length(0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data = static_cast<const char*>(p);
+                length = st.st_size;
+            }
+        }
+
+        close(fd);
+    }
+
+    ~mapped_file() {
+        if (data)
+            munmap(const_cast<char*>(data), length);
+    }
+
+    const char* data;
+    std::size_t length;
+};
+
+/// single pass reader for the subset of JSON used by compilation databases
+class json_reader {
+public:
+    json_reader(const char* data, std::size_t length) : failed(false), cur(data), end(data + length) {}
+
+    /// skips whitespace and consumes c if it is next
+    bool accept(char c) {
+        skip_ws();
+        if (cur < end && *cur == c) {
+            ++cur;
+            return true;
+        }
+
+        return false;
+    }
+
+    /// consumes c or fails
+    bool expect(char c) {
+        if (!accept(c))
+            failed = true;
+
+        return !failed;
+    }
+
+    /// reads a string into out
+    bool string(std::string& out) {
+        out.clear();
+        if (!expect('"'))
+            return false;
+
+        while (cur < end && *cur != '"') {
+            // copy runs without escapes at once
+            const char* run = cur;
+            while (cur < end && *cur != '"' && *cur != '\\')
+                ++cur;
+
+            out.append(run, cur);
+            if (cur < end && *cur == '\\') {
+                if (++cur == end)
+                    break;
+
+                switch (*cur++) {
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': unicode(out); break;
+                    default: out += cur[-1]; break;
+                }
+            }
+        }
+
+        return expect('"');
+    }
+
+    /// skips any value
+    void skip() {
+        skip_ws();
+        if (cur == end) {
+            failed = true;
+            return;
+        }
+
+        if (*cur == '"') {
+            std::string ignored;
+            string(ignored);
+        } else if (*cur == '[' || *cur == '{') {
+            char close = *cur == '[' ? ']' : '}';
+            ++cur;
+            if (accept(close))
+                return;
+
+            do {
+                if (close == '}') {
+                    std::string key;
+                    string(key);
+                    expect(':');
+                }
+
+                skip();
+            } while (!failed && accept(','));
+
+            expect(close);
+        } else {
+            // numbers, true, false, null
+            while (cur < end && *cur != ',' && *cur != '}' && *cur != ']' && !isspace(*cur))
+                ++cur;
+        }
+    }
+
+    bool failed;
+private:
+    void skip_ws() {
+        while (cur < end && (*cur == ' ' || *cur == '\n' || *cur == '\r' || *cur == '\t'))
+            ++cur;
+    }
+
+    bool isspace(char c) const {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    /// reads 4 hex digits
+    uint32_t hex4() {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i, ++cur) {
+            if (cur == end) {
+                failed = true;
+                return 0;
+            }
+
+            char c = *cur;
+            v <<= 4;
+            if (c >= '0' && c <= '9')
+                v |= c - '0';
+            else if (c >= 'a' && c <= 'f')
+                v |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                v |= c - 'A' + 10;
+        }
+
+        return v;
+    }
+
+    /// decodes \uXXXX, including surrogate pairs, to UTF-8
+    void unicode(std::string& out) {
+        uint32_t cp = hex4();
+        if (cp >= 0xD800 && cp < 0xDC00 && end - cur >= 6 && cur[0] == '\\' && cur[1] == 'u') {
+            cur += 2;
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (hex4() - 0xDC00);
+        }
+
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    const char* cur;
+    const char* end;
+};
+
+/// splits a command line the way a POSIX shell would, without expansions
+static void split_command(const std::string& command, std::vector<std::string>& out) {
+    std::string token;
+    bool in_token = false;
+
+    for (std::size_t i = 0; i < command.size(); ++i) {
+        char c = command[i];
+
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            if (in_token)
+                out.push_back(token);
+
+            token.clear();
+            in_token = false;
+            continue;
+        }
+
+        in_token = true;
+        if (c == '\\' && i + 1 < command.size()) {
+            token += command[++i];
+        } else if (c == '\'') {
+            while (++i < command.size() && command[i] != '\'')
+                token += command[i];
+        } else if (c == '"') {
+            while (++i < command.size() && command[i] != '"') {
+                if (command[i] == '\\' && i + 1 < command.size()
+                    && (command[i + 1] == '"' || command[i + 1] == '\\'))
+                {
+                    ++i;
+                }
+
+                token += command[i];
+            }
+        } else {
+            token += c;
+        }
+    }
+
+    if (in_token)
+        out.push_back(token);
+}
+
+/// true for the compile-only, output and dependency flags with no separate value
+static bool dropped(const std::string& token) {
+    if (token.size() < 2 || token[0] != '-')
+        return false;
+
+    if (token[1] == 'c')
+        return token.size() == 2;
+
+    // -o<path>, flags like -objcmt-* or -ordered-* aren't output files
+    if (token[1] == 'o')
+        return token.compare(0, 4, "-obj") != 0 && token.find_first_of("./", 2) != std::string::npos;
+
+    if (token[1] != 'M' || token.size() < 3)
+        return false;
+
+    char kind = token[2];
+    if (kind == 'F' || kind == 'T' || kind == 'Q')
+        return true;
+
+    return token == "-MD" || token == "-MMD" || token == "-MP";
+}
+
+/// constructor
+compilation_database::compilation_database() : next_id(1) {}
+
+/// joins arguments with NUL
+static std::string pack(const std::vector<std::string>& args) {
+    std::string ret;
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        if (i)
+            ret += '\0';
+
+        ret += args[i];
+    }
+
+    return ret;
+}
+
+/// canonical arguments
+std::vector<std::string> normalize_arguments(const std::vector<std::string>& args) {
+    std::vector<std::string> ret;
+    std::set<std::pair<std::string, std::string>> dirs;
+
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        const char* flag = include_flag(arg);
+
+        // -D / -U only differ in spelling
+        if (!flag && (arg == "-D" || arg == "-U") && i + 1 < args.size()) {
+            ret.push_back(arg + args[++i]);
+            continue;
+        }
+
+        if (!flag) {
+            ret.push_back(arg);
+            continue;
+        }
+
+        std::string value = arg.substr(strlen(flag));
+        if (value.empty() && i + 1 < args.size())
+            value = args[++i];
+
+        if (!value.empty())
+            value = normalize_path(value);
+
+        // clang ignores a directory that is already searched
+        if (!dirs.insert(std::make_pair(std::string(flag), value)).second)
+            continue;
+
+        if (strcmp(flag, "-I") == 0 || strcmp(flag, "-F") == 0) {
+            ret.push_back(flag + value);
+        } else {
+            ret.push_back(flag);
+            ret.push_back(value);
+        }
+    }
+
+    return ret;
+}
+
+/// set lookup / creation
+uint32_t compilation_database::intern(const std::string& packed, std::unordered_map<uint32_t, argument_set>& into,
+    std::unordered_map<std::string, uint32_t, content_hasher>& known, uint32_t& next)
+{
+    // keyed by content, sets whose hashes collide stay apart
+    auto id = known.insert(std::make_pair(packed, next));
+    if (id.second)
+        ++next;
+
+    if (!into.count(id.first->second)) {
+        argument_set set;
+        set.packed = packed;
+        into[id.first->second] = set;
+    }
+
+    return id.first->second;
+}
+
+/// load
+bool compilation_database::load(const std::string& dir) {
+    std::string path = dir + "/compile_commands.json";
+    file_stamp next_stamp;
+    next_stamp.read(path.c_str());
+
+    mapped_file file(path);
+    if (!file.data)
+        return false;
+
+    std::unordered_map<std::string, uint32_t> next_files;
+    std::unordered_map<uint32_t, argument_set> next_sets;
+    std::unordered_map<std::string, uint32_t, content_hasher> next_ids = ids;
+    std::unordered_map<std::string, uint32_t, content_hasher> raw_ids;
+    uint32_t next_next_id = next_id;
+
+    json_reader json(file.data, file.length);
+    std::string key, directory, filename, command, value;
+    std::vector<std::string> tokens, filtered;
+
+    if (!json.expect('['))
+        return false;
+
+    if (!json.accept(']')) {
+        do {
+            directory.clear();
+            filename.clear();
+            command.clear();
+            tokens.clear();
+
+            if (!json.expect('{'))
+                return false;
+
+            if (!json.accept('}')) {
+                do {
+                    json.string(key);
+                    json.expect(':');
+
+                    if (key == "directory") {
+                        json.string(directory);
+                    } else if (key == "file") {
+                        json.string(filename);
+                    } else if (key == "command") {
+                        json.string(command);
+                    } else if (key == "arguments" && json.accept('[')) {
+                        if (!json.accept(']')) {
+                            do {
+                                json.string(value);
+                                tokens.push_back(value);
+                            } while (!json.failed && json.accept(','));
+
+                            json.expect(']');
+                        }
+                    } else {
+                        json.skip();
+                    }
+                } while (!json.failed && json.accept(','));
+
+                json.expect('}');
+            }
+
+            if (json.failed)
+                return false;
+
+            // "arguments" takes precedence over "command"
+            if (tokens.empty())
+                split_command(command, tokens);
+
+            std::string file_path = filename;
+            if (file_path.empty() || file_path[0] != '/')
+                file_path = directory + "/" + file_path;
+
+            file_path = normalize_path(file_path);
+
+            std::size_t slash = file_path.rfind('/');
+            std::string base = file_path.substr(slash == std::string::npos ? 0 : slash + 1);
+
+            // the first argument is the compiler
+            filtered.clear();
+            filtered.push_back("-working-directory=" + directory);
+            for (std::size_t a = 1; a < tokens.size(); ++a) {
+                const std::string& token = tokens[a];
+
+                // output and dependency files, the source is handed to clang separately
+                if (token == "-o" || token == "-MF" || token == "-MT" || token == "-MQ") {
+                    ++a;
+                    continue;
+                }
+
+                if (dropped(token))
+                    continue;
+
+                // the source may be spelled differently than "file", only look closer if the name matches
+                if (token == filename || token == file_path)
+                    continue;
+
+                if (token[0] != '-' && token.size() >= base.size()
+                    && token.compare(token.size() - base.size(), base.size(), base) == 0
+                    && normalize_path(token[0] == '/' ? token : directory + "/" + token) == file_path)
+                {
+                    continue;
+                }
+
+                filtered.push_back(token);
+            }
+
+            // most files share their arguments verbatim, only normalize those not seen before
+            auto cached = raw_ids.insert(std::make_pair(pack(filtered), 0));
+            if (cached.second)
+                cached.first->second = intern(pack(normalize_arguments(filtered)), next_sets, next_ids, next_next_id);
+
+            uint32_t id = cached.first->second;
+
+            // the first command wins if a file is built more than once
+            next_files.insert(std::make_pair(file_path, id));
+        } while (json.accept(','));
+    }
+
+    if (!json.expect(']'))
+        return false;
+
+    // sets of single files survive a reload
+    for (auto &entry : overrides)
+        next_sets[entry.second] = sets.at(entry.second);
+    for (auto id : retained)
+        next_sets[id] = sets.at(id);
+
+    files.swap(next_files);
+    sets.swap(next_sets);
+    ids.swap(next_ids);
+    next_id = next_next_id;
+    source = path;
+    stamp = next_stamp;
+    return true;
+}
+
+/// change check
+bool compilation_database::unchanged(const std::string& dir) const {
+    file_stamp current;
+    return source == dir + "/compile_commands.json" && current.read(source.c_str()) && current == stamp;
+}
+
+/// lookup
+uint32_t compilation_database::lookup(const std::string& path) const {
+    std::string key = normalize_path(path);
+
+    auto it = overrides.find(key);
+    if (it != overrides.end())
+        return it->second;
+
+    it = files.find(key);
+    return it == files.end() ? 0 : it->second;
+}
+
+/// single file
+uint32_t compilation_database::set_file(const std::string& path, const std::vector<std::string>& args) {
+    uint32_t id = intern(pack(normalize_arguments(args)), sets, ids, next_id);
+    overrides[normalize_path(path)] = id;
+    return id;
+}
+
+/// single file removal
+void compilation_database::unset_file(const std::string& path) {
+    overrides.erase(normalize_path(path));
+}
+
+/// set without a file
+uint32_t compilation_database::add_set(const std::vector<std::string>& args) {
+    uint32_t id = intern(pack(normalize_arguments(args)), sets, ids, next_id);
+    retained.insert(id);
+    return id;
+}
+
+/// arguments of a set
+const std::vector<std::string>& compilation_database::arguments(uint32_t id) const {
+    const argument_set& set = sets.at(id);
+    if (set.args.empty() && !set.packed.empty()) {
+        std::size_t pos = 0;
+        while (pos <= set.packed.size()) {
+            std::size_t next = set.packed.find('\0', pos);
+            if (next == std::string::npos)
+                next = set.packed.size();
+
+            set.args.push_back(set.packed.substr(pos, next - pos));
+            pos = next + 1;
+        }
+    }
+
+    return set.args;
+}
+
+/// clear
+void compilation_database::clear() {
+    files.clear();
+    source.clear();
+
+    // keep the sets of single files and those added on their own
+    std::unordered_map<uint32_t, argument_set> kept;
+    for (auto &entry : overrides)
+        kept[entry.second] = sets.at(entry.second);
+    for (auto id : retained)
+        kept[id] = sets.at(id);
+
+    sets.swap(kept);
+}
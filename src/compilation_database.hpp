@@ -0,0 +1,128 @@
+/**
+* @file compilation_database.hpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License. *
+*/
+
+#ifndef _CLANG_TOOL_COMPILATION_DATABASE_HPP_
+#define _CLANG_TOOL_COMPILATION_DATABASE_HPP_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "content_hash.hpp"
+
+/**
+ * Returns args with equivalent spellings unified, e.g. "-I", "dir" becomes "-Idir", and repeated
+ * include directories removed. The order is kept.
+ */
+std::vector<std::string> normalize_arguments(const std::vector<std::string>& args);
+
+/**
+ * Per-file compiler arguments from a compile_commands.json.
+ *
+ * Files built with the same arguments share a single argument set, identified by a number starting
+ * at 1. The compiler itself, the file name and output related arguments are stripped, the build
+ * directory is passed on as -working-directory.
+ *
+ * The file is mapped and parsed in a single pass. Argument sets are looked up by a hash of their
+ * arguments, compared in full on a match, and kept as one packed string, the argument vector is
+ * built the first time a set is used. A set keeps its number when the database is loaded again, so files whose arguments
+ * didn't change keep their set.
+ */
+class compilation_database {
+public:
+    /** Constructor */
+    compilation_database();
+
+    /** Loads the compile_commands.json in dir, returns false and leaves the database as is if it can't be read */
+    bool load(const std::string& dir);
+
+    /** Returns whether the compile_commands.json last loaded from dir is unchanged on disk */
+    bool unchanged(const std::string& dir) const;
+
+    /** Returns whether an argument set is still in use */
+    bool contains(uint32_t id) const {
+        return sets.count(id) != 0;
+    }
+
+    /** Returns the argument set of path, 0 if the database has no entry for it */
+    uint32_t lookup(const std::string& path) const;
+
+    /** Gives path its own arguments, taking precedence over its entry, returns the set */
+    uint32_t set_file(const std::string& path, const std::vector<std::string>& args);
+
+    /** Removes the arguments given to path with set_file */
+    void unset_file(const std::string& path);
+
+    /** Returns the set holding args without assigning it to a file, it is kept across reloads */
+    uint32_t add_set(const std::vector<std::string>& args);
+
+    /** Returns the arguments of a set returned by lookup */
+    const std::vector<std::string>& arguments(uint32_t id) const;
+
+    /** Returns the number of files */
+    std::size_t size() const {
+        return files.size();
+    }
+
+    /** Forgets all entries */
+    void clear();
+private:
+    /** Arguments shared by one or more files */
+    struct argument_set {
+        /** Arguments separated by NUL */
+        std::string packed;
+        /** Unpacked arguments, empty until first requested */
+        mutable std::vector<std::string> args;
+    };
+
+    /** Returns the number of the set holding packed arguments, adding it to into if needed */
+    static uint32_t intern(const std::string& packed, std::unordered_map<uint32_t, argument_set>& into,
+        std::unordered_map<std::string, uint32_t, content_hasher>& known, uint32_t& next);
+
+    /** Argument set of each normalized file path */
+    std::unordered_map<std::string, uint32_t> files;
+
+    /** Argument sets given to single files, by normalized path */
+    std::unordered_map<std::string, uint32_t> overrides;
+
+    /** Argument sets added with add_set */
+    std::unordered_set<uint32_t> retained;
+
+    /** Argument sets in use */
+    std::unordered_map<uint32_t, argument_set> sets;
+
+    /** Number of each argument set ever seen, by packed arguments */
+    std::unordered_map<std::string, uint32_t, content_hasher> ids;
+
+    /** Number of the next new argument set */
+    uint32_t next_id;
+
+    /** Where the database was loaded from */
+    std::string source;
+
+    /** Stamp of the loaded file */
+    file_stamp stamp;
+};
+
+#endif /* _CLANG_TOOL_COMPILATION_DATABASE_HPP_ */
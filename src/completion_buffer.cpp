@@ -0,0 +1,125 @@
+/**
+* @file completion_buffer.cpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+*/
+
+#include <unordered_map>
+
+#include "completion_buffer.hpp"
+
+/// format version, bump when the layout changes
+static const uint32_t completion_buffer_version = 2;
+
+/// optional field wasn't requested
+static const uint32_t completion_buffer_none = 0xFFFFFFFF;
+
+/// deduplicating string table
+class string_table {
+public:
+    /// returns the index of s, adding it if required
+    uint32_t intern(const std::string& s) {
+        auto it = index.find(s);
+        if (it != index.end())
+            return it->second;
+
+        uint32_t id = strings.size();
+        index.emplace(s, id);
+        strings.push_back(&s);
+        return id;
+    }
+
+    /// strings in order of their index
+    std::vector<const std::string*> strings;
+private:
+    std::unordered_map<std::string, uint32_t> index;
+};
+
+/// appends a little endian uint32
+static inline void put_u32(std::string& out, uint32_t v) {
+    char b[4] = {
+        static_cast<char>(v & 0xFF), static_cast<char>((v >> 8) & 0xFF),
+        static_cast<char>((v >> 16) & 0xFF), static_cast<char>((v >> 24) & 0xFF)
+    };
+
+    out.append(b, 4);
+}
+
+/// encode
+std::string completion_encode(const std::vector<const completion_candidate*>& candidates, uint32_t total,
+    const completion_options& opts)
+{
+    string_table table;
+    std::vector<uint32_t> records;
+    std::vector<uint32_t> args;
+
+    records.reserve(candidates.size() * 9);
+
+    for (auto candidate : candidates) {
+        records.push_back(table.intern(candidate->name));
+        records.push_back(table.intern(candidate->return_type));
+        records.push_back(opts.brief ? table.intern(candidate->brief) : completion_buffer_none);
+        records.push_back(static_cast<uint32_t>(candidate->type));
+        records.push_back(candidate->priority);
+        records.push_back(args.size());
+        records.push_back(candidate->args.size());
+
+        for (auto &arg : candidate->args)
+            args.push_back(table.intern(arg));
+
+        if (opts.snippet) {
+            records.push_back(table.intern(candidate->snippet));
+            records.push_back(table.intern(candidate->label));
+        } else {
+            records.push_back(completion_buffer_none);
+            records.push_back(completion_buffer_none);
+        }
+    }
+
+    std::size_t bytes = 0;
+    for (auto s : table.strings)
+        bytes += s->size();
+
+    std::string out;
+    out.reserve((5 + records.size() + args.size() + table.strings.size() + 1) * 4 + bytes);
+
+    put_u32(out, completion_buffer_version);
+    put_u32(out, candidates.size());
+    put_u32(out, total);
+    put_u32(out, args.size());
+    put_u32(out, table.strings.size());
+
+    for (auto v : records)
+        put_u32(out, v);
+
+    for (auto v : args)
+        put_u32(out, v);
+
+    uint32_t offset = 0;
+    put_u32(out, offset);
+    for (auto s : table.strings) {
+        offset += s->size();
+        put_u32(out, offset);
+    }
+
+    for (auto s : table.strings)
+        out.append(*s);
+
+    return out;
+}
@@ -0,0 +1,53 @@
+/**
+* @file completion_buffer.hpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License. *
+*/
+
+#ifndef _CLANG_TOOL_COMPLETION_BUFFER_HPP_
+#define _CLANG_TOOL_COMPLETION_BUFFER_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "clang/clang_tool.hpp"
+#include "completion_filter.hpp"
+
+/**
+ * Serializes completion candidates into a single binary buffer.
+ *
+ * All values are little endian uint32:
+ *
+ *   header   version, count, total, arg count, string count
+ *   records  count * (name, return_type, brief, type, priority, first arg, arg count, snippet, label)
+ *   args     arg count * string index
+ *   offsets  (string count + 1) * byte offset into the string data
+ *   strings  utf-8 string data
+ *
+ * name, return_type, brief and args are indices into the string table, equal
+ * strings are stored once. brief, snippet and label are 0xFFFFFFFF if they
+ * weren't requested.
+ *
+ * See lib/completion_buffer.js for the decoder.
+ */
+std::string completion_encode(const std::vector<const completion_candidate*>& candidates, uint32_t total,
+    const completion_options& opts);
+
+#endif /* _CLANG_TOOL_COMPLETION_BUFFER_HPP_ */
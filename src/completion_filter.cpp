@@ -0,0 +1,227 @@
+/**
+* @file completion_filter.cpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include <clang-c/Index.h>
+
+#include "completion_filter.hpp"
+
+/// ascii lower case
+static inline uint8_t fold(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? c | 0x20 : c;
+}
+
+/// folds all characters in s into a 64 bit set, branch free so the compiler can vectorize it
+static inline uint64_t char_mask(const std::string& s) {
+    uint64_t mask = 0;
+    for (std::size_t i = 0; i < s.size(); ++i)
+        mask |= 1ull << (fold(static_cast<uint8_t>(s[i])) & 63);
+
+    return mask;
+}
+
+/// whether name[i] starts a word, e.g. the B in fooBar or foo_bar
+static inline bool word_start(const std::string& name, std::size_t i) {
+    if (i == 0)
+        return true;
+
+    char prev = name[i-1];
+    char cur = name[i];
+    return prev == '_' || (prev >= 'a' && prev <= 'z' && cur >= 'A' && cur <= 'Z');
+}
+
+/// adds a kind
+void completion_options::accept_kind(clang::completion_type type) {
+    kinds |= 1u << static_cast<uint32_t>(type);
+}
+
+/// flags
+unsigned completion_options::flags() const {
+    unsigned ret = 0;
+    if (macros)
+        ret |= CXCodeComplete_IncludeMacros;
+    if (patterns)
+        ret |= CXCodeComplete_IncludeCodePatterns;
+    if (brief)
+        ret |= CXCodeComplete_IncludeBriefComments;
+
+    return ret;
+}
+
+/// context filter
+bool completion_options::accepts_contexts(uint64_t reported) const {
+    return !contexts || (contexts & reported);
+}
+
+/// kind filters
+bool completion_options::accepts(const clang::completion& candidate) const {
+    if (!macros && candidate.type == clang::completion_type::macro_t)
+        return false;
+
+    if (kinds && !(kinds & (1u << static_cast<uint32_t>(candidate.type))))
+        return false;
+
+    return true;
+}
+
+/// constructor
+completion_matcher::completion_matcher(const std::string& pattern, bool fuzzy)
+    : pattern(pattern), folded(pattern), mask(char_mask(pattern)), fuzzy(fuzzy)
+{
+    std::transform(folded.begin(), folded.end(), folded.begin(), [](char c) {
+        return static_cast<char>(fold(static_cast<uint8_t>(c)));
+    });
+}
+
+/// match quality
+int32_t completion_matcher::score(const std::string& name) const {
+    if (pattern.empty())
+        return 0;
+
+    if (name.size() < pattern.size())
+        return -1;
+
+    // reject early if name lacks one of the characters
+    if ((char_mask(name) & mask) != mask)
+        return -1;
+
+    int32_t score = 0;
+    std::size_t p = 0;
+    std::size_t last = 0;
+
+    for (std::size_t i = 0; i < name.size() && p < folded.size(); ++i) {
+        if (fold(static_cast<uint8_t>(name[i])) != static_cast<uint8_t>(folded[p])) {
+            // prefix mode requires the pattern to match from the start
+            if (!fuzzy)
+                return -1;
+
+            continue;
+        }
+
+        score += 1;
+        if (name[i] == pattern[p])
+            score += 1;
+        if (word_start(name, i))
+            score += 8;
+        if (p > 0 && i == last + 1)
+            score += 4;
+
+        last = i;
+        ++p;
+    }
+
+    if (p != folded.size())
+        return -1;
+
+    // prefer short names when the match is equally good
+    return score * 16 - static_cast<int32_t>(std::min<std::size_t>(name.size() - pattern.size(), 15));
+}
+
+/// filter, rank, truncate
+uint32_t completion_select(const std::vector<completion_candidate>& comp, const completion_options& opts,
+    std::vector<const completion_candidate*>& out)
+{
+    completion_matcher matcher(opts.filter, opts.fuzzy);
+
+    // rank and index into comp
+    std::vector<std::pair<int32_t, uint32_t>> ranked;
+    ranked.reserve(comp.size());
+
+    for (uint32_t i = 0; i < comp.size(); ++i) {
+        if (!opts.accepts(comp[i]))
+            continue;
+
+        int32_t score = matcher.score(comp[i].name);
+        if (score < 0)
+            continue;
+
+        // clang priorities are lower for better candidates
+        ranked.push_back(std::make_pair(score * 128 - static_cast<int32_t>(std::min<uint32_t>(comp[i].priority, 127)), i));
+    }
+
+    uint32_t total = ranked.size();
+    std::size_t keep = (opts.limit && opts.limit < total) ? opts.limit : total;
+
+    // without filter and limit, keep clang's order
+    if (!opts.filter.empty() || opts.limit) {
+        std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end(),
+            [](const std::pair<int32_t, uint32_t>& a, const std::pair<int32_t, uint32_t>& b) {
+                return a.first != b.first ? a.first > b.first : a.second < b.second;
+            }
+        );
+    }
+
+    out.clear();
+    out.reserve(keep);
+    for (std::size_t i = 0; i < keep; ++i)
+        out.push_back(&comp[ranked[i].second]);
+
+    return total;
+}
+
+/// session reuse
+bool completion_session::matches(const std::string& path, uint32_t row, uint32_t col, const std::string& filter,
+    unsigned flags) const
+{
+    const unsigned patterns = CXCodeComplete_IncludeCodePatterns;
+    return !this->path.empty() && this->path == path && this->row == row && this->col == col
+        && filter.compare(0, this->filter.size(), this->filter) == 0
+        && (this->flags & flags) == flags && (this->flags & patterns) == (flags & patterns);
+}
+
+/// end session
+void completion_session::clear() {
+    path.clear();
+    filter.clear();
+    flags = 0;
+    contexts = 0;
+    candidates.clear();
+}
+
+/// member access in front of the cursor
+bool completion_trigger(const char* content, std::size_t length, uint32_t row, uint32_t col) {
+    if (row == 0 || col < 2)
+        return false;
+
+    // find the start of the row
+    std::size_t offset = 0;
+    for (uint32_t r = 1; r < row; ++r) {
+        const void* nl = memchr(content + offset, '\n', length - offset);
+        if (!nl)
+            return false;
+
+        offset = static_cast<const char*>(nl) - content + 1;
+    }
+
+    // rows and columns are 1-based, the trigger ends right before the cursor
+    offset += col - 1;
+    if (offset > length)
+        return false;
+
+    char last = content[offset - 1];
+    char prev = offset >= 2 ? content[offset - 2] : 0;
+
+    return last == '.' || (last == '>' && prev == '-') || (last == ':' && prev == ':');
+}
@@ -0,0 +1,158 @@
+/**
+* @file completion_filter.hpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License. *
+*/
+
+#ifndef _CLANG_TOOL_COMPLETION_FILTER_HPP_
+#define _CLANG_TOOL_COMPLETION_FILTER_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "clang/clang_tool.hpp"
+
+/** Completion candidate with the text to insert and display, formatted from clang's chunks */
+struct completion_candidate : clang::completion {
+    /** Insert snippet with optional arguments and template parameters, e.g. foo(${1:int i}${2:, ${3:int j}}) */
+    std::string snippet;
+    /** Display label, e.g. foo(int i, int j) */
+    std::string label;
+    /** Whether it is an overload of the call the completion point is in, see CXCursor_OverloadCandidate */
+    bool overload;
+    /** Parameter of the overload the completion point is at, -1 if clang doesn't mark one */
+    int32_t active;
+
+    /** Constructor */
+    completion_candidate() : overload(false), active(-1) {}
+};
+
+/** Per-request options for code completion */
+struct completion_options {
+    /** Include macro candidates */
+    bool macros;
+    /** Include code patterns, e.g. for / while blocks */
+    bool patterns;
+    /** Marshal brief comments */
+    bool brief;
+    /** Bitmask of accepted completion types, 0 accepts all */
+    uint32_t kinds;
+    /** Bitmask of CXCompletionContext values, nothing is returned if clang reports none of them, 0 accepts all */
+    uint64_t contexts;
+    /** Text typed so far, candidates not matching it are dropped */
+    std::string filter;
+    /** Match the filter as a subsequence instead of a prefix */
+    bool fuzzy;
+    /** Maximum number of candidates returned, 0 returns all */
+    uint32_t limit;
+    /** Return the results as a buffer, see completion_encode */
+    bool binary;
+    /** Add pre-formatted snippet and label strings */
+    bool snippet;
+
+    /** Constructor, defaults to returning everything */
+    completion_options()
+        : macros(true), patterns(true), brief(true), kinds(0), contexts(0), fuzzy(true), limit(0), binary(false),
+          snippet(false) {}
+
+    /** Adds the given completion type to the accepted kinds */
+    void accept_kind(clang::completion_type type);
+
+    /** Returns the CXCodeComplete_* flags clang has to be called with */
+    unsigned flags() const;
+
+    /** Returns whether clang's reported contexts are among the requested ones */
+    bool accepts_contexts(uint64_t reported) const;
+
+    /** Returns whether the candidate passes the kind filters */
+    bool accepts(const clang::completion& candidate) const;
+};
+
+/** Case-insensitive prefix / subsequence matcher for candidate names */
+class completion_matcher {
+public:
+    /** Constructor */
+    completion_matcher(const std::string& pattern, bool fuzzy);
+
+    /** Returns the match quality for name, -1 if it doesn't match */
+    int32_t score(const std::string& name) const;
+private:
+    /** Pattern as typed */
+    std::string pattern;
+    /** Lower-cased pattern */
+    std::string folded;
+    /** Characters present in the pattern, see char_mask */
+    uint64_t mask;
+    /** Subsequence or prefix matching */
+    bool fuzzy;
+};
+
+/**
+ * Unfiltered completion results for a single token.
+ *
+ * Candidates are requested at the start of the token being typed, so as long
+ * as the user keeps extending the same token the set doesn't change and can
+ * be re-filtered without asking clang again.
+ */
+struct completion_session {
+    /** File the session belongs to, empty if there is none */
+    std::string path;
+    /** Row of the token */
+    uint32_t row;
+    /** Column at which the token starts */
+    uint32_t col;
+    /** Filter of the request that started the session */
+    std::string filter;
+    /** CXCodeComplete_* flags the candidates were requested with */
+    unsigned flags;
+    /** CXCompletionContext bits reported by clang */
+    uint64_t contexts;
+    /** Candidates returned by clang */
+    std::vector<completion_candidate> candidates;
+
+    /** Constructor */
+    completion_session() : row(0), col(0), flags(0), contexts(0) {}
+
+    /**
+     * Returns whether a request for the given token can be served from this session.
+     *
+     * Macros and brief comments are dropped after the fact, code patterns can't be told apart
+     * once clang is done so their flag has to match.
+     */
+    bool matches(const std::string& path, uint32_t row, uint32_t col, const std::string& filter,
+        unsigned flags) const;
+
+    /** Ends the session */
+    void clear();
+};
+
+/** Returns whether the text in front of row / col ends in '.', '->' or '::' */
+bool completion_trigger(const char* content, std::size_t length, uint32_t row, uint32_t col);
+
+/**
+ * Filters and ranks candidates according to opts.
+ *
+ * Stores pointers to the best opts.limit candidates in out, best first, and
+ * returns the number of candidates that matched before truncation.
+ */
+uint32_t completion_select(const std::vector<completion_candidate>& comp, const completion_options& opts,
+    std::vector<const completion_candidate*>& out);
+
+#endif /* _CLANG_TOOL_COMPLETION_FILTER_HPP_ */
@@ -0,0 +1,132 @@
+/**
+* @file content_hash.cpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+*/
+
+#include <cstring>
+#include <sys/stat.h>
+
+#include "content_hash.hpp"
+
+static const uint64_t prime1 = 11400714785074694791ULL;
+static const uint64_t prime2 = 14029467366897019727ULL;
+static const uint64_t prime3 = 1609587929392839161ULL;
+static const uint64_t prime4 = 9650029242287828579ULL;
+static const uint64_t prime5 = 2870177450012600261ULL;
+
+/// rotate left
+static inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+/// unaligned little endian reads
+static inline uint64_t read64(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t read32(const char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/// mixes 8 bytes into an accumulator
+static inline uint64_t lane(uint64_t acc, uint64_t input) {
+    acc += input * prime2;
+    acc = rotl(acc, 31);
+    return acc * prime1;
+}
+
+/// folds an accumulator into the hash
+static inline uint64_t merge(uint64_t hash, uint64_t acc) {
+    hash ^= lane(0, acc);
+    return hash * prime1 + prime4;
+}
+
+/// xxh64, the four independent lanes keep the main loop pipelined
+uint64_t content_hash(const char* data, std::size_t length) {
+    const char* p = data;
+    const char* end = data + length;
+    uint64_t hash;
+
+    if (length >= 32) {
+        uint64_t v1 = prime1 + prime2;
+        uint64_t v2 = prime2;
+        uint64_t v3 = 0;
+        uint64_t v4 = 0 - prime1;
+
+        const char* limit = end - 32;
+        do {
+            v1 = lane(v1, read64(p));
+            v2 = lane(v2, read64(p + 8));
+            v3 = lane(v3, read64(p + 16));
+            v4 = lane(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = merge(hash, v1);
+        hash = merge(hash, v2);
+        hash = merge(hash, v3);
+        hash = merge(hash, v4);
+    } else {
+        hash = prime5;
+    }
+
+    hash += length;
+
+    for (; p + 8 <= end; p += 8)
+        hash = rotl(hash ^ lane(0, read64(p)), 27) * prime1 + prime4;
+
+    if (p + 4 <= end) {
+        hash = rotl(hash ^ (read32(p) * prime1), 23) * prime2 + prime3;
+        p += 4;
+    }
+
+    for (; p < end; ++p)
+        hash = rotl(hash ^ (static_cast<unsigned char>(*p) * prime5), 11) * prime1;
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+/// stat
+bool file_stamp::read(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return false;
+
+    size = st.st_size;
+    inode = st.st_ino;
+#if defined(__APPLE__)
+    mtime = st.st_mtimespec.tv_sec * 1000000000ULL + st.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+    mtime = st.st_mtime * 1000000000ULL;
+#else
+    mtime = st.st_mtim.tv_sec * 1000000000ULL + st.st_mtim.tv_nsec;
+#endif
+    return true;
+}
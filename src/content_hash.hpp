@@ -0,0 +1,65 @@
+/**
+* @file content_hash.hpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License. *
+*/
+
+#ifndef _CLANG_TOOL_CONTENT_HASH_HPP_
+#define _CLANG_TOOL_CONTENT_HASH_HPP_
+
+#include <cstdint>
+#include <string>
+
+/** Returns the XXH64 hash of data, used to tell whether content changed */
+uint64_t content_hash(const char* data, std::size_t length);
+
+/** Returns the XXH64 hash of data */
+inline uint64_t content_hash(const std::string& data) {
+    return content_hash(data.c_str(), data.size());
+}
+
+/** Hashes strings with content_hash, for unordered containers keyed by content */
+struct content_hasher {
+    std::size_t operator()(const std::string& data) const {
+        return static_cast<std::size_t>(content_hash(data));
+    }
+};
+
+/** File metadata that changes whenever the file is written */
+struct file_stamp {
+    /** Size in bytes */
+    uint64_t size;
+    /** Modification time in nanoseconds */
+    uint64_t mtime;
+    /** Inode, changes when the file is replaced instead of written to */
+    uint64_t inode;
+
+    /** Constructor */
+    file_stamp() : size(0), mtime(0), inode(0) {}
+
+    /** Reads the stamp of path, returns false if it can't be stat'ed */
+    bool read(const char* path);
+
+    /** Whether both stamps describe the same file state */
+    bool operator==(const file_stamp& other) const {
+        return size == other.size && mtime == other.mtime && inode == other.inode;
+    }
+};
+
+#endif /* _CLANG_TOOL_CONTENT_HASH_HPP_ */
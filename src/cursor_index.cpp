@@ -0,0 +1,102 @@
+/**
+* @file cursor_index.cpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+*/
+
+#include <algorithm>
+
+#include "cursor_index.hpp"
+
+/// add extent
+void cursor_index::add(uint32_t begin_row, uint32_t begin_col, uint32_t end_row, uint32_t end_col, uint32_t cursor,
+    bool function)
+{
+    extent e;
+    e.begin = position(begin_row, begin_col);
+    e.end = position(end_row, end_col);
+    e.parent = -1;
+    e.cursor = cursor;
+    e.function = function;
+
+    // empty ranges can't contain a position
+    if (e.begin >= e.end)
+        return;
+
+    extents.push_back(e);
+    sorted = false;
+}
+
+/// sort and link
+void cursor_index::build() {
+    // ties keep the order they were added in, children are visited after their parent
+    auto before = [](const extent& a, const extent& b) {
+        return a.begin != b.begin ? a.begin < b.begin : a.end > b.end;
+    };
+
+    // extents added in a depth first traversal are mostly in order already
+    if (!std::is_sorted(extents.begin(), extents.end(), before))
+        std::stable_sort(extents.begin(), extents.end(), before);
+
+    std::vector<int32_t> open;
+    for (std::size_t i = 0; i < extents.size(); ++i) {
+        while (!open.empty() && extents[open.back()].end <= extents[i].begin)
+            open.pop_back();
+
+        extents[i].parent = open.empty() ? -1 : open.back();
+        open.push_back(static_cast<int32_t>(i));
+    }
+
+    entries.assign(extents.size(), entry());
+    sorted = true;
+}
+
+/// innermost extent
+int32_t cursor_index::find(uint32_t row, uint32_t col) const {
+    if (!sorted)
+        return -1;
+
+    uint64_t pos = position(row, col);
+    auto it = std::upper_bound(extents.begin(), extents.end(), pos, [](uint64_t p, const extent& e) {
+        return p < e.begin;
+    });
+
+    // the last extent starting in front of pos or one of its parents contains it
+    int32_t i = static_cast<int32_t>(it - extents.begin()) - 1;
+    while (i >= 0 && extents[i].end <= pos)
+        i = extents[i].parent;
+
+    return i;
+}
+
+/// innermost function
+int32_t cursor_index::find_function(uint32_t row, uint32_t col) const {
+    int32_t i = find(row, col);
+    while (i >= 0 && !extents[i].function)
+        i = extents[i].parent;
+
+    return i;
+}
+
+/// clear
+void cursor_index::clear() {
+    extents.clear();
+    entries.clear();
+    sorted = true;
+}
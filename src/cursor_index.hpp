@@ -0,0 +1,133 @@
+/**
+* @file cursor_index.hpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License. *
+*/
+
+#ifndef _CLANG_TOOL_CURSOR_INDEX_HPP_
+#define _CLANG_TOOL_CURSOR_INDEX_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "clang/clang_tool.hpp"
+
+/** Facets of a cursor lookup */
+enum cursor_field : uint32_t {
+    cursor_field_type        = 1 << 0,
+    cursor_field_declaration = 1 << 1,
+    cursor_field_definition  = 1 << 2,
+    cursor_field_docs        = 1 << 3,
+    cursor_field_default     = cursor_field_type | cursor_field_declaration | cursor_field_definition,
+    cursor_field_all         = cursor_field_default | cursor_field_docs
+};
+
+/**
+ * Source extents of the cursors in a single file.
+ *
+ * Extents are kept in a flat array sorted by their start, each linking to the
+ * innermost extent enclosing it. The cursor at a position is found with a
+ * binary search followed by a walk up the enclosing extents, so every position
+ * inside the same token shares one entry. The index belongs to a single parse
+ * of the file and is rebuilt with it.
+ */
+class cursor_index {
+public:
+    /** Lookup results for a single cursor */
+    struct entry {
+        /** Facets that have been looked up, see cursor_field */
+        uint32_t fields;
+        /** Type under the cursor */
+        std::string type;
+        /** Where the cursor is declared */
+        clang::location declaration;
+        /** Where the cursor is defined */
+        clang::location definition;
+        /** First paragraph of the documentation comment of the referenced declaration */
+        std::string brief;
+        /** Full documentation comment of the referenced declaration, including the comment markers */
+        std::string comment;
+
+        /** Constructor */
+        entry() : fields(0) {}
+    };
+
+    /** Source range of a cursor, the end is exclusive */
+    struct extent {
+        /** Start, row in the upper 32 bits */
+        uint64_t begin;
+        /** End, row in the upper 32 bits */
+        uint64_t end;
+        /** Index of the enclosing extent, -1 if there is none */
+        int32_t parent;
+        /** Id of the cursor as passed to add */
+        uint32_t cursor;
+        /** Whether the cursor is a function, method or lambda */
+        bool function;
+    };
+
+    /** Constructor */
+    cursor_index() : sorted(true) {}
+
+    /** Adds the extent of a cursor, build has to be called before the next lookup */
+    void add(uint32_t begin_row, uint32_t begin_col, uint32_t end_row, uint32_t end_col, uint32_t cursor,
+        bool function);
+
+    /** Sorts the extents and links them to their parents */
+    void build();
+
+    /** Returns the index of the innermost extent containing row / col, -1 if there is none */
+    int32_t find(uint32_t row, uint32_t col) const;
+
+    /** Returns the index of the innermost function containing row / col, -1 if there is none */
+    int32_t find_function(uint32_t row, uint32_t col) const;
+
+    /** Returns the extent at i */
+    const extent& at(int32_t i) const {
+        return extents[i];
+    }
+
+    /** Returns the cached lookups of the extent at i */
+    entry& info(int32_t i) {
+        return entries[i];
+    }
+
+    /** Returns the number of extents stored */
+    std::size_t size() const {
+        return extents.size();
+    }
+
+    /** Drops all extents */
+    void clear();
+
+    /** Converts a row / col to the position key used by extent */
+    static uint64_t position(uint32_t row, uint32_t col) {
+        return (static_cast<uint64_t>(row) << 32) | col;
+    }
+private:
+    /** Extents sorted by start, enclosing extents first */
+    std::vector<extent> extents;
+    /** Cached lookups, one per extent */
+    std::vector<entry> entries;
+    /** Whether build has been called since the last add */
+    bool sorted;
+};
+
+#endif /* _CLANG_TOOL_CURSOR_INDEX_HPP_ */
@@ -0,0 +1,108 @@
+/**
+* @file file_overlay.cpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+*/
+
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+
+#include <clang-c/BuildSystem.h>
+
+#include "file_overlay.hpp"
+
+/// constructor
+file_overlay::file_overlay() : revision(0) {}
+
+/// destructor
+file_overlay::~file_overlay() {
+    if (dir.empty())
+        return;
+
+    if (!overlay.empty())
+        unlink(overlay.c_str());
+
+    rmdir(dir.c_str());
+}
+
+/// temporary directory
+bool file_overlay::prepare() {
+    if (!dir.empty())
+        return true;
+
+    const char* tmp = getenv("TMPDIR");
+    std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp") + "/clang-tool-XXXXXX";
+
+    if (!mkdtemp(&pattern[0]))
+        return false;
+
+    dir = pattern;
+    return true;
+}
+
+/// map existing files
+bool file_overlay::remap(const std::map<std::string, std::string>& files) {
+    if (files == remapped)
+        return true;
+
+    if (!prepare())
+        return false;
+
+    // keep the previous mappings if one of the new ones is rejected
+    std::map<std::string, std::string> previous;
+    previous.swap(remapped);
+    remapped = files;
+
+    if (write())
+        return true;
+
+    remapped.swap(previous);
+    write();
+    return false;
+}
+
+/// serialize
+bool file_overlay::write() {
+    // relative virtual paths are rejected
+    bool ok = true;
+    CXVirtualFileOverlay vfs = clang_VirtualFileOverlay_create(0);
+    for (auto &mapping : remapped)
+        ok = ok && clang_VirtualFileOverlay_addFileMapping(vfs, mapping.first.c_str(), mapping.second.c_str()) == CXError_Success;
+
+    char* buffer = nullptr;
+    unsigned size = 0;
+    ok = ok && clang_VirtualFileOverlay_writeToBuffer(vfs, 0, &buffer, &size) == CXError_Success;
+    clang_VirtualFileOverlay_dispose(vfs);
+
+    if (!ok)
+        return false;
+
+    // always the same path, translation units only pick up new mappings when their arguments are set
+    ++revision;
+    std::string path = dir + "/overlay.yaml";
+    std::ofstream file(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    ok = static_cast<bool>(file.write(buffer, size));
+    clang_free(buffer);
+
+    if (ok)
+        overlay = path;
+
+    return ok;
+}
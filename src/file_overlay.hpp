@@ -0,0 +1,86 @@
+/**
+* @file file_overlay.hpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License. *
+*/
+
+#ifndef _CLANG_TOOL_FILE_OVERLAY_HPP_
+#define _CLANG_TOOL_FILE_OVERLAY_HPP_
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * Virtual file system overlay shared by all translation units.
+ *
+ * Maps virtual paths to existing files, e.g. generated headers. The overlay is written to a private
+ * temporary directory and passed to clang through -ivfsoverlay. Unsaved content isn't part of it, it
+ * is handed to clang with each parse.
+ */
+class file_overlay {
+public:
+    /** Constructor */
+    file_overlay();
+
+    /** Destructor, removes the temporary files */
+    ~file_overlay();
+
+    /**
+     * Replaces the paths mapped to existing files, e.g. generated headers.
+     *
+     * Returns false and keeps the previous mappings if the overlay can't be written or clang rejects
+     * one of the paths, e.g. because it isn't absolute.
+     */
+    bool remap(const std::map<std::string, std::string>& files);
+
+    /** Path of the overlay to pass to -ivfsoverlay, empty until something has been mapped */
+    const std::string& file() const {
+        return overlay;
+    }
+
+    /** Incremented whenever the mappings change */
+    uint32_t version() const {
+        return revision;
+    }
+private:
+    /** Not copyable, owns the temporary files */
+    file_overlay(const file_overlay&);
+    file_overlay& operator=(const file_overlay&);
+
+    /** Creates the temporary directory */
+    bool prepare();
+
+    /** Writes the overlay for the current mappings */
+    bool write();
+
+    /** Temporary directory, created on first use */
+    std::string dir;
+
+    /** Path of the written overlay */
+    std::string overlay;
+
+    /** Virtual path to an existing file */
+    std::map<std::string, std::string> remapped;
+
+    /** Changes of the mappings */
+    uint32_t revision;
+};
+
+#endif /* _CLANG_TOOL_FILE_OVERLAY_HPP_ */
@@ -0,0 +1,163 @@
+/**
+* @file include_graph.cpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+*/
+
+#include <cstring>
+
+#include "include_graph.hpp"
+
+/// collapses "." and ".." segments and duplicate separators
+std::string normalize_path(const std::string& path) {
+    // most paths are clean already
+    bool clean = !path.empty() && path.back() != '/' && path.find("//") == std::string::npos
+        && path.find("/./") == std::string::npos && path.find("/../") == std::string::npos
+        && path.compare(0, 2, "./") != 0 && path.compare(0, 3, "../") != 0
+        && !(path.size() >= 2 && path.compare(path.size() - 2, 2, "/.") == 0)
+        && !(path.size() >= 3 && path.compare(path.size() - 3, 3, "/..") == 0)
+        && path != "." && path != "..";
+
+    if (clean)
+        return path;
+
+    std::vector<std::string> parts;
+    std::size_t pos = 0;
+
+    while (pos <= path.size()) {
+        std::size_t next = path.find('/', pos);
+        if (next == std::string::npos)
+            next = path.size();
+
+        std::string part = path.substr(pos, next - pos);
+        if (part == "..") {
+            if (!parts.empty() && parts.back() != "..")
+                parts.pop_back();
+            else if (path.empty() || path[0] != '/')
+                parts.push_back(part);
+        } else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+
+        pos = next + 1;
+    }
+
+    std::string ret = !path.empty() && path[0] == '/' ? "/" : "";
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        if (i)
+            ret += '/';
+        ret += parts[i];
+    }
+
+    return ret;
+}
+
+/// the flag arg is spelled with, compared exactly so longer flags sharing its prefix don't match
+const char* include_flag(const std::string& arg) {
+    static const char* flags[] = {"-I", "-F", "-isystem", "-iquote", "-idirafter"};
+
+    for (auto f : flags) {
+        std::size_t len = strlen(f);
+        if (arg.compare(0, len, f) != 0)
+            continue;
+
+        if (arg.size() == len || arg[len] != '-')
+            return f;
+    }
+
+    return nullptr;
+}
+
+/// replace direct includes
+void include_graph::assign(const std::string& path, const std::vector<std::string>& headers) {
+    remove(path);
+    std::vector<std::string>& out = includes[path];
+    out.reserve(headers.size());
+
+    for (auto &name : headers) {
+        // files included more than once, e.g. without include guards, are reported each time
+        std::string header = normalize_path(name);
+        if (header != path && includers[header].insert(path).second)
+            out.push_back(header);
+    }
+}
+
+/// includes of a parse
+void include_graph::update(const std::string& path, const inclusion_map& inclusions) {
+    // a unit that failed to parse reports nothing, its previous includes are gone either way
+    std::string main = normalize_path(path);
+    bool found = false;
+
+    for (auto &entry : inclusions) {
+        std::string file = normalize_path(entry.first);
+        found = found || file == main;
+        assign(file, entry.second);
+    }
+
+    if (!found)
+        assign(main, std::vector<std::string>());
+}
+
+/// reverse lookup
+std::vector<std::string> include_graph::dependents(const std::string& path) const {
+    std::vector<std::string> ret;
+    std::set<std::string> seen;
+    seen.insert(normalize_path(path));
+    ret.push_back(normalize_path(path));
+
+    // breadth first, so direct includers come before indirect ones
+    for (std::size_t i = 0; i < ret.size(); ++i) {
+        auto it = includers.find(ret[i]);
+        if (it == includers.end())
+            continue;
+
+        for (auto &includer : it->second) {
+            if (seen.insert(includer).second)
+                ret.push_back(includer);
+        }
+    }
+
+    ret.erase(ret.begin());
+    return ret;
+}
+
+/// remove
+void include_graph::remove(const std::string& path) {
+    auto it = includes.find(normalize_path(path));
+    if (it == includes.end())
+        return;
+
+    for (auto &header : it->second) {
+        auto rev = includers.find(header);
+        if (rev == includers.end())
+            continue;
+
+        rev->second.erase(it->first);
+        if (rev->second.empty())
+            includers.erase(rev);
+    }
+
+    includes.erase(it);
+}
+
+/// clear
+void include_graph::clear() {
+    includes.clear();
+    includers.clear();
+}
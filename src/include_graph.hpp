@@ -0,0 +1,76 @@
+/**
+* @file include_graph.hpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License. *
+*/
+
+#ifndef _CLANG_TOOL_INCLUDE_GRAPH_HPP_
+#define _CLANG_TOOL_INCLUDE_GRAPH_HPP_
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/** Returns path with "." and ".." segments and duplicate separators collapsed */
+std::string normalize_path(const std::string& path);
+
+/**
+ * Returns the search directory flag arg is, e.g. "-I" for "-I" and "-Idir", nullptr if it isn't one.
+ *
+ * Only -I, -F, -isystem, -iquote and -idirafter are recognized. Their value is either joined or the
+ * next argument; a joined value can't start with '-', so e.g. -isystem-after isn't read as -isystem.
+ */
+const char* include_flag(const std::string& arg);
+
+/** Direct includes of every file of a translation unit, files that include nothing map to an empty list */
+typedef std::map<std::string, std::vector<std::string>> inclusion_map;
+
+/**
+ * Which files include which, as reported by clang for each parsed translation unit.
+ *
+ * Only includes that were active in the last parse are known, a header's includes are updated
+ * whenever a translation unit including it is parsed again. Headers found through the compiler's
+ * builtin search paths are tracked like any other.
+ */
+class include_graph {
+public:
+    /** Replaces the includes of path and of every file it includes with the ones of its last parse */
+    void update(const std::string& path, const inclusion_map& inclusions);
+
+    /** Returns all files that include path directly or indirectly, closest first */
+    std::vector<std::string> dependents(const std::string& path) const;
+
+    /** Forgets the includes of path */
+    void remove(const std::string& path);
+
+    /** Forgets everything */
+    void clear();
+private:
+    /** Replaces the direct includes of path */
+    void assign(const std::string& path, const std::vector<std::string>& headers);
+
+    /** Directly included files of each file */
+    std::map<std::string, std::vector<std::string>> includes;
+
+    /** Files directly including each file */
+    std::map<std::string, std::set<std::string>> includers;
+};
+
+#endif /* _CLANG_TOOL_INCLUDE_GRAPH_HPP_ */
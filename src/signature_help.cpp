@@ -0,0 +1,273 @@
+/**
+* @file signature_help.cpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+*/
+
+#include "signature_help.hpp"
+
+/// identifier character
+static inline bool ident_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+/// open bracket in front of the cursor
+struct bracket {
+    /** Bracket character */
+    char c;
+    /** Offset of the bracket */
+    std::size_t offset;
+    /** Row of the bracket */
+    uint32_t row;
+    /** Column of the bracket */
+    uint32_t col;
+    /** Commas seen inside, not counting nested brackets */
+    uint32_t commas;
+    /** Row behind the last comma or the bracket */
+    uint32_t arg_row;
+    /** Column behind the last comma or the bracket */
+    uint32_t arg_col;
+    /** Row behind the last comma outside of template arguments or the bracket */
+    uint32_t outer_row;
+    /** Column behind the last comma outside of template arguments or the bracket */
+    uint32_t outer_col;
+    /** Number of template argument lists open inside */
+    uint32_t angles;
+    /** Whether a statement ended inside, e.g. for (;;) */
+    bool statement;
+};
+
+/// call site
+call_site call_site_at(const char* content, std::size_t length, uint32_t row, uint32_t col) {
+    call_site ret;
+    if (row == 0 || col == 0)
+        return ret;
+
+    std::vector<bracket> open;
+    open.reserve(16);
+
+    // rows and columns are 1-based
+    uint32_t r = 1;
+    std::size_t line = 0;
+    std::size_t end = length;
+
+    for (std::size_t i = 0; i < end && r <= row; ++i) {
+        char c = content[i];
+
+        // the cursor offset is only known once its row has been reached
+        if (c == '\n') {
+            if (r == row) {
+                end = i;
+                break;
+            }
+
+            ++r;
+            line = i + 1;
+            continue;
+        }
+
+        if (r == row && i - line + 1 >= col) {
+            end = i;
+            break;
+        }
+
+        char next = i + 1 < length ? content[i+1] : '\0';
+        char prev = i > 0 ? content[i-1] : '\0';
+
+        // comments
+        if (c == '/' && next == '/') {
+            while (i + 1 < length && content[i+1] != '\n')
+                ++i;
+            continue;
+        }
+
+        if (c == '/' && next == '*') {
+            for (i += 2; i + 1 < length && !(content[i] == '*' && content[i+1] == '/'); ++i) {
+                if (content[i] == '\n') {
+                    ++r;
+                    line = i + 1;
+                }
+            }
+
+            ++i;
+            continue;
+        }
+
+        // digit separators, e.g. 1'000
+        if (c == '\'' && ident_char(prev)) {
+            std::size_t start = i;
+            while (start > 0 && ident_char(content[start-1]))
+                --start;
+
+            if (content[start] >= '0' && content[start] <= '9')
+                continue;
+        }
+
+        // raw string literals, R"delim( ... )delim"
+        if (c == '"' && prev == 'R' && (i < 2 || !ident_char(content[i-2]) || content[i-2] == '8'
+            || content[i-2] == 'u' || content[i-2] == 'U' || content[i-2] == 'L'))
+        {
+            std::size_t paren = i + 1;
+            while (paren < length && content[paren] != '(' && content[paren] != '\n')
+                ++paren;
+
+            std::string close = ")" + std::string(content + i + 1, paren - i - 1) + "\"";
+            for (i = paren; i < length && (content[i] != ')' || length - i < close.size()
+                || close.compare(0, close.size(), content + i, close.size()) != 0); ++i)
+            {
+                if (content[i] == '\n') {
+                    ++r;
+                    line = i + 1;
+                }
+            }
+
+            i += close.size() - 1;
+            continue;
+        }
+
+        // literals, unterminated ones end with the line
+        if (c == '"' || c == '\'') {
+            while (i + 1 < length && content[i+1] != c && content[i+1] != '\n') {
+                if (content[i+1] == '\\')
+                    ++i;
+                ++i;
+            }
+
+            if (i + 1 < length && content[i+1] == c)
+                ++i;
+            continue;
+        }
+
+        bracket* top = open.empty() ? nullptr : &open.back();
+
+        switch (c) {
+            case '(':
+            case '[':
+            case '{': {
+                uint32_t at = static_cast<uint32_t>(i - line + 1);
+                open.push_back(bracket{c, i, r, at, 0, r, at + 1, r, at + 1, 0, false});
+                break;
+            }
+            case ')':
+            case ']':
+            case '}':
+                // unbalanced brackets in front of the cursor are ignored
+                if (top && top->c == (c == ')' ? '(' : (c == ']' ? '[' : '{')))
+                    open.pop_back();
+                break;
+            case '<':
+                // template arguments directly follow a name, a<<b and a<=b are operators
+                if (top && ident_char(prev) && next != '<' && next != '=')
+                    ++top->angles;
+                break;
+            case '>':
+                if (top && top->angles && prev != '-')
+                    --top->angles;
+                break;
+            case ',':
+                if (!top)
+                    break;
+
+                top->arg_row = r;
+                top->arg_col = static_cast<uint32_t>(i - line + 2);
+                if (!top->angles) {
+                    top->outer_row = top->arg_row;
+                    top->outer_col = top->arg_col;
+                    ++top->commas;
+                }
+                break;
+            case ';':
+                if (top)
+                    top->statement = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // the cursor is past the end of the content
+    if (r != row || end - line + 1 < col)
+        return ret;
+
+    if (open.empty() || open.back().c != '(' || open.back().statement)
+        return ret;
+
+    const bracket& paren = open.back();
+
+    // name in front of the parenthesis
+    std::size_t last = paren.offset;
+    while (last > 0 && (content[last-1] == ' ' || content[last-1] == '\t'))
+        --last;
+
+    std::size_t first = last;
+    while (first > 0 && ident_char(content[first-1]))
+        --first;
+
+    ret.name.assign(content + first, last - first);
+    ret.row = paren.row;
+    ret.col = paren.col;
+    ret.arg_row = paren.arg_row;
+    ret.arg_col = paren.arg_col;
+    ret.outer_row = paren.outer_row;
+    ret.outer_col = paren.outer_col;
+    ret.commas = paren.commas;
+    ret.found = true;
+    return ret;
+}
+
+/// cache hit
+bool signature_cache::matches(const std::string& path, const call_site& site) const {
+    return !this->path.empty() && this->path == path && row == site.row && col == site.col && name == site.name
+        && arg_row == site.arg_row && arg_col == site.arg_col;
+}
+
+/// pick overloads
+bool signature_cache::assign(const std::string& path, const call_site& site, const std::vector<completion_candidate>& comp) {
+    this->path = path;
+    row = site.row;
+    col = site.col;
+    name = site.name;
+    arg_row = site.arg_row;
+    arg_col = site.arg_col;
+    active = site.commas;
+    signatures.clear();
+
+    // clang only offers overloads at the start of an argument, they mark the parameter it belongs to
+    bool marked = false;
+    for (auto &candidate : comp) {
+        if (!candidate.overload)
+            continue;
+
+        if (!marked && candidate.active >= 0) {
+            active = candidate.active;
+            marked = true;
+        }
+
+        signatures.push_back(candidate);
+    }
+
+    return !signatures.empty();
+}
+
+/// clear
+void signature_cache::clear() {
+    path.clear();
+    name.clear();
+    signatures.clear();
+}
@@ -0,0 +1,100 @@
+/**
+* @file signature_help.hpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License. *
+*/
+
+#ifndef _CLANG_TOOL_SIGNATURE_HELP_HPP_
+#define _CLANG_TOOL_SIGNATURE_HELP_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "clang/clang_tool.hpp"
+#include "completion_filter.hpp"
+
+/** Innermost call surrounding a cursor position */
+struct call_site {
+    /** Whether the cursor is inside an argument list */
+    bool found;
+    /** Row of the opening parenthesis */
+    uint32_t row;
+    /** Column of the opening parenthesis */
+    uint32_t col;
+    /** Name of the function called, empty if it isn't a plain identifier */
+    std::string name;
+    /** Row of the argument the cursor is in, right behind the last comma or the parenthesis */
+    uint32_t arg_row;
+    /** Column of the argument the cursor is in */
+    uint32_t arg_col;
+    /** Row of the argument if the last comma separates template arguments instead */
+    uint32_t outer_row;
+    /** Column of the argument if the last comma separates template arguments instead */
+    uint32_t outer_col;
+    /** Commas in front of the cursor outside of template arguments, a guess at the argument index */
+    uint32_t commas;
+
+    /** Constructor */
+    call_site() : found(false), row(0), col(0), arg_row(0), arg_col(0), outer_row(0), outer_col(0), commas(0) {}
+};
+
+/**
+ * Returns the argument list the cursor at row / col is in.
+ *
+ * Scans the code in front of the cursor, skipping comments and literals. Whether a comma inside <>
+ * directly following a name separates template arguments or follows a comparison can't be told
+ * without parsing, clang is asked at arg_row / arg_col first and at outer_row / outer_col if that
+ * doesn't yield a call.
+ */
+call_site call_site_at(const char* content, std::size_t length, uint32_t row, uint32_t col);
+
+/** Overload candidates for a single call site, kept while the cursor moves between its arguments */
+struct signature_cache {
+    /** File the call is in, empty if there is none */
+    std::string path;
+    /** Row of the opening parenthesis */
+    uint32_t row;
+    /** Column of the opening parenthesis */
+    uint32_t col;
+    /** Name of the function called */
+    std::string name;
+    /** Row of the argument the overloads were requested at */
+    uint32_t arg_row;
+    /** Column of the argument the overloads were requested at */
+    uint32_t arg_col;
+    /** Index of the argument, as marked by clang */
+    uint32_t active;
+    /** Overloads clang offered for the call */
+    std::vector<completion_candidate> signatures;
+
+    /** Constructor */
+    signature_cache() : row(0), col(0), arg_row(0), arg_col(0), active(0) {}
+
+    /** Returns whether the cache holds the overloads for the argument of site the cursor is in */
+    bool matches(const std::string& path, const call_site& site) const;
+
+    /** Picks the overload candidates from a completion run at the start of the argument, returns false if there are none */
+    bool assign(const std::string& path, const call_site& site, const std::vector<completion_candidate>& comp);
+
+    /** Drops the cached overloads */
+    void clear();
+};
+
+#endif /* _CLANG_TOOL_SIGNATURE_HELP_HPP_ */
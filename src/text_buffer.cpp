@@ -0,0 +1,186 @@
+/**
+* @file text_buffer.cpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "text_buffer.hpp"
+
+/// pieces after which the buffer is flattened, keeps lookups short
+static const std::size_t text_buffer_max_pieces = 256;
+
+/// last revision handed out, buffers replaced by new ones never repeat one
+static uint64_t text_buffer_revisions = 0;
+
+/// records newline positions of data, offset by base
+static void index_lines(std::vector<std::size_t>& out, const char* data, std::size_t length, std::size_t base) {
+    const char* cur = data;
+    const char* end = data + length;
+
+    while (cur < end) {
+        const void* nl = memchr(cur, '\n', end - cur);
+        if (!nl)
+            break;
+
+        out.push_back(static_cast<const char*>(nl) - data + base);
+        cur = static_cast<const char*>(nl) + 1;
+    }
+}
+
+/// constructor
+text_buffer::text_buffer() : original(std::make_shared<const std::string>()), length(0),
+    changes(++text_buffer_revisions) {}
+
+/// assign
+void text_buffer::assign(const char* data, std::size_t length) {
+    reset(std::make_shared<const std::string>(data, length));
+    changes = ++text_buffer_revisions;
+}
+
+/// assign, same revision
+void text_buffer::reset(std::shared_ptr<const std::string> content) {
+    std::size_t length = content->size();
+    original = std::move(content);
+    added.clear();
+    original_lines.clear();
+    added_lines.clear();
+    index_lines(original_lines, original->data(), length, 0);
+
+    pieces.clear();
+    if (length)
+        pieces.push_back(piece{false, 0, length});
+
+    this->length = length;
+}
+
+/// newlines in p
+std::size_t text_buffer::lines(const piece& p) const {
+    const std::vector<std::size_t>& idx = p.added ? added_lines : original_lines;
+    auto first = std::lower_bound(idx.begin(), idx.end(), p.start);
+    auto last = std::lower_bound(first, idx.end(), p.start + p.length);
+    return last - first;
+}
+
+/// row / col to offset
+std::size_t text_buffer::offset(uint32_t row, uint32_t col) const {
+    std::size_t pos = 0;
+    std::size_t remaining = row > 0 ? row - 1 : 0;
+
+    // find the piece containing the newline that ends the previous row
+    std::size_t line_start = 0;
+    if (remaining) {
+        bool found = false;
+
+        for (auto &p : pieces) {
+            std::size_t n = lines(p);
+            if (n < remaining) {
+                remaining -= n;
+                pos += p.length;
+                continue;
+            }
+
+            const std::vector<std::size_t>& idx = p.added ? added_lines : original_lines;
+            auto first = std::lower_bound(idx.begin(), idx.end(), p.start);
+            line_start = pos + (first[remaining - 1] - p.start) + 1;
+            found = true;
+            break;
+        }
+
+        if (!found)
+            return length;
+    }
+
+    std::size_t ret = line_start + (col > 0 ? col - 1 : 0);
+    return ret > length ? length : ret;
+}
+
+/// split at pos
+std::size_t text_buffer::split(std::size_t pos) {
+    std::size_t cur = 0;
+
+    for (std::size_t i = 0; i < pieces.size(); ++i) {
+        if (cur == pos)
+            return i;
+
+        if (pos < cur + pieces[i].length) {
+            piece tail = pieces[i];
+            std::size_t head = pos - cur;
+
+            pieces[i].length = head;
+            tail.start += head;
+            tail.length -= head;
+            pieces.insert(pieces.begin() + i + 1, tail);
+            return i + 1;
+        }
+
+        cur += pieces[i].length;
+    }
+
+    return pieces.size();
+}
+
+/// replace range
+void text_buffer::replace(std::size_t begin, std::size_t end, const char* text, std::size_t length) {
+    if (begin > this->length)
+        begin = this->length;
+    if (end > this->length)
+        end = this->length;
+    if (end < begin)
+        end = begin;
+
+    std::size_t first = split(begin);
+    std::size_t last = split(end);
+    pieces.erase(pieces.begin() + first, pieces.begin() + last);
+
+    if (length) {
+        std::size_t start = added.size();
+        added.append(text, length);
+        index_lines(added_lines, text, length, start);
+        pieces.insert(pieces.begin() + first, piece{true, start, length});
+    }
+
+    this->length = this->length - (end - begin) + length;
+    changes = ++text_buffer_revisions;
+
+    if (pieces.size() > text_buffer_max_pieces)
+        view();
+}
+
+/// contiguous content
+const std::string& text_buffer::view() {
+    if (pieces.size() == 1 && !pieces[0].added && pieces[0].start == 0 && pieces[0].length == original->size())
+        return *original;
+
+    if (pieces.empty()) {
+        reset(std::make_shared<const std::string>());
+        return *original;
+    }
+
+    std::string flat;
+    flat.reserve(length);
+    for (auto &p : pieces)
+        flat.append((p.added ? added : *original), p.start, p.length);
+
+    // the flattened content becomes the new original, so there is only one copy
+    reset(std::make_shared<const std::string>(std::move(flat)));
+    return *original;
+}
@@ -0,0 +1,114 @@
+/**
+* @file text_buffer.hpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License. *
+*/
+
+#ifndef _CLANG_TOOL_TEXT_BUFFER_HPP_
+#define _CLANG_TOOL_TEXT_BUFFER_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Piece table holding the unsaved content of a file.
+ *
+ * Edits only append to the add buffer and split pieces, the content is made
+ * contiguous again when view() is called, e.g. before handing it to clang.
+ * The contiguous content is never modified in place, share() hands it out
+ * without copying.
+ * Newline positions of both buffers are indexed so rows can be resolved
+ * without scanning the text.
+ */
+class text_buffer {
+public:
+    /** Constructor */
+    text_buffer();
+
+    /** Replaces the whole content */
+    void assign(const char* data, std::size_t length);
+
+    /** Replaces the whole content */
+    void assign(const std::string& data) {
+        assign(data.c_str(), data.size());
+    }
+
+    /** Returns the byte offset of the 1-based row / col, clamped to the size of the buffer */
+    std::size_t offset(uint32_t row, uint32_t col) const;
+
+    /** Replaces the bytes in [begin, end) with text */
+    void replace(std::size_t begin, std::size_t end, const char* text, std::size_t length);
+
+    /** Returns the content as a contiguous string */
+    const std::string& view();
+
+    /** Returns the content as a contiguous string that stays valid after the buffer changes */
+    std::shared_ptr<const std::string> share() {
+        view();
+        return original;
+    }
+
+    /** Returns the size in bytes */
+    std::size_t size() const {
+        return length;
+    }
+
+    /** Returns a number that changes with every assign / replace, unique across all buffers */
+    uint64_t revision() const {
+        return changes;
+    }
+private:
+    /** Span of either the original or the add buffer */
+    struct piece {
+        /** Whether the piece points into added */
+        bool added;
+        /** Offset into the buffer */
+        std::size_t start;
+        /** Length in bytes */
+        std::size_t length;
+    };
+
+    /** Replaces the whole content without counting it as a change */
+    void reset(std::shared_ptr<const std::string> content);
+
+    /** Returns the number of newlines in p */
+    std::size_t lines(const piece& p) const;
+
+    /** Makes sure a piece starts at pos and returns its index */
+    std::size_t split(std::size_t pos);
+
+    /** Content the buffer was assigned / last flattened to */
+    std::shared_ptr<const std::string> original;
+    /** Appended text of all edits */
+    std::string added;
+    /** Newline positions in original */
+    std::vector<std::size_t> original_lines;
+    /** Newline positions in added */
+    std::vector<std::size_t> added_lines;
+    /** Pieces in order */
+    std::vector<piece> pieces;
+    /** Total size */
+    std::size_t length;
+    /** Revision of the content */
+    uint64_t changes;
+};
+
+#endif /* _CLANG_TOOL_TEXT_BUFFER_HPP_ */
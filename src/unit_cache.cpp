@@ -0,0 +1,689 @@
+/**
+* @file unit_cache.cpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+*/
+
+#include "unit_cache.hpp"
+
+/// converts and frees a libclang string
+static std::string to_string(CXString str) {
+    const char* c = clang_getCString(str);
+    std::string ret = c ? c : "";
+    clang_disposeString(str);
+    return ret;
+}
+
+/// file, row and column a location expands to
+static clang::location to_location(CXSourceLocation loc) {
+    CXFile file;
+    unsigned row, col, offset;
+    clang_getExpansionLocation(loc, &file, &row, &col, &offset);
+
+    clang::location ret;
+    ret.file = file ? to_string(clang_getFileName(file)) : std::string();
+    ret.row = row;
+    ret.col = col;
+    return ret;
+}
+
+/// location of a cursor, empty for the null cursor
+static clang::location cursor_location(CXCursor cursor) {
+    if (clang_Cursor_isNull(cursor)) {
+        clang::location ret;
+        ret.row = 0;
+        ret.col = 0;
+        return ret;
+    }
+
+    return to_location(clang_getCursorLocation(cursor));
+}
+
+/// completion type of a cursor kind
+static clang::completion_type completion_kind(CXCursorKind kind) {
+    switch (kind) {
+        case CXCursor_Namespace:
+        case CXCursor_NamespaceAlias:
+            return clang::completion_type::namespace_t;
+        case CXCursor_ClassDecl:
+        case CXCursor_ClassTemplate:
+        case CXCursor_ClassTemplatePartialSpecialization:
+            return clang::completion_type::class_t;
+        case CXCursor_FieldDecl:
+            return clang::completion_type::attribute_t;
+        case CXCursor_CXXMethod:
+        case CXCursor_Constructor:
+        case CXCursor_Destructor:
+        case CXCursor_ConversionFunction:
+            return clang::completion_type::method_t;
+        case CXCursor_ParmDecl:
+            return clang::completion_type::parameter_t;
+        case CXCursor_StructDecl:
+            return clang::completion_type::struct_t;
+        case CXCursor_FunctionDecl:
+        case CXCursor_FunctionTemplate:
+            return clang::completion_type::function_t;
+        case CXCursor_EnumDecl:
+            return clang::completion_type::enum_t;
+        case CXCursor_EnumConstantDecl:
+            return clang::completion_type::enum_static_t;
+        case CXCursor_UnionDecl:
+            return clang::completion_type::union_t;
+        case CXCursor_TypedefDecl:
+        case CXCursor_TypeAliasDecl:
+            return clang::completion_type::typedef_t;
+        case CXCursor_VarDecl:
+            return clang::completion_type::variable_t;
+        case CXCursor_MacroDefinition:
+            return clang::completion_type::macro_t;
+        case CXCursor_InclusionDirective:
+            return clang::completion_type::include_t;
+        default:
+            return clang::completion_type::unkown_t;
+    }
+}
+
+/// collects the declarations of the main file
+static CXChildVisitResult ast_visitor(CXCursor cursor, CXCursor, CXClientData data) {
+    CXCursorKind kind = clang_getCursorKind(cursor);
+
+    // statements are skipped, along with everything declared inside function bodies
+    if (!clang_Location_isFromMainFile(clang_getCursorLocation(cursor)) || !clang_isDeclaration(kind))
+        return CXChildVisit_Continue;
+
+    clang::ast_element* parent = static_cast<clang::ast_element*>(data);
+    parent->children.push_back(clang::ast_element());
+
+    clang::ast_element& e = parent->children.back();
+    e.name = to_string(clang_getCursorSpelling(cursor));
+    e.type = to_string(clang_getTypeSpelling(clang_getCursorType(cursor)));
+    if (kind == CXCursor_TypedefDecl || kind == CXCursor_TypeAliasDecl)
+        e.typedefType = to_string(clang_getTypeSpelling(clang_getTypedefDeclUnderlyingType(cursor)));
+
+    e.doc = to_string(clang_Cursor_getBriefCommentText(cursor));
+    e.cursor = completion_kind(kind);
+    e.access = clang_getCXXAccessSpecifier(cursor);
+    e.loc = to_location(clang_getCursorLocation(cursor));
+
+    clang_visitChildren(cursor, ast_visitor, &e);
+    return CXChildVisit_Continue;
+}
+
+/// constructor
+translation_unit::translation_unit(const std::string& path)
+    : path(path), index(clang_createIndex(0, 0)), unit(nullptr), skip_bodies(false), indexed(false),
+      fresh(false), footprint(0), measured(false) {}
+
+/// destructor
+translation_unit::~translation_unit() {
+    if (unit)
+        clang_disposeTranslationUnit(unit);
+
+    clang_disposeIndex(index);
+}
+
+/// new content
+bool translation_unit::parse(const std::vector<std::string>& args, bool outline, unsaved_files unsaved) {
+    std::lock_guard<std::mutex> guard(lock);
+    this->unsaved = std::move(unsaved);
+    return load(args, outline);
+}
+
+/// parse from scratch
+void translation_unit::renew() {
+    std::lock_guard<std::mutex> guard(lock);
+    fresh = true;
+}
+
+/// new arguments / mode
+bool translation_unit::refresh(const std::vector<std::string>& args, bool outline) {
+    std::lock_guard<std::mutex> guard(lock);
+    return load(args, outline);
+}
+
+/// parse / reparse
+bool translation_unit::load(const std::vector<std::string>& args, bool outline) {
+    // cursors don't survive a reparse
+    cursors.clear();
+    visited.clear();
+    indexed = false;
+    measured = false;
+
+    // clang reads the content in place
+    std::vector<CXUnsavedFile> files = unsaved_array(nullptr, 0);
+    CXUnsavedFile* first = files.empty() ? nullptr : &files[0];
+
+    // the preamble is reused as long as the arguments are the same
+    if (unit && !fresh && args == this->args && outline == skip_bodies) {
+        if (clang_reparseTranslationUnit(unit, files.size(), first, clang_defaultReparseOptions(unit)) == 0)
+            return true;
+    }
+
+    // a unit whose reparse failed can't be used anymore
+    if (unit) {
+        clang_disposeTranslationUnit(unit);
+        unit = nullptr;
+    }
+
+    this->args = args;
+    skip_bodies = outline;
+    fresh = false;
+
+    std::vector<const char*> argv;
+    for (auto &arg : args)
+        argv.push_back(arg.c_str());
+
+    unsigned options = CXTranslationUnit_KeepGoing;
+    if (outline) {
+        options |= CXTranslationUnit_SkipFunctionBodies;
+    } else {
+        options |= clang_defaultEditingTranslationUnitOptions() | CXTranslationUnit_CreatePreambleOnFirstParse
+            | CXTranslationUnit_IncludeBriefCommentsInCodeCompletion;
+    }
+
+    CXErrorCode err = clang_parseTranslationUnit2(index, path.c_str(), argv.empty() ? nullptr : &argv[0], argv.size(),
+        first, files.size(), options, &unit);
+
+    if (err != CXError_Success)
+        unit = nullptr;
+
+    return unit != nullptr;
+}
+
+/// unsaved content for clang
+std::vector<CXUnsavedFile> translation_unit::unsaved_array(const char* content, std::size_t length) const {
+    std::vector<CXUnsavedFile> ret;
+    ret.reserve(unsaved.size() + 1);
+
+    for (auto &file : unsaved) {
+        if (content && file.path == path)
+            continue;
+
+        CXUnsavedFile f;
+        f.Filename = file.path.c_str();
+        f.Contents = file.content->data();
+        f.Length = file.content->size();
+        ret.push_back(f);
+    }
+
+    if (content) {
+        CXUnsavedFile f;
+        f.Filename = path.c_str();
+        f.Contents = content;
+        f.Length = length;
+        ret.push_back(f);
+    }
+
+    return ret;
+}
+
+/// memory usage
+unsigned long translation_unit::memory() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!unit)
+        return 0;
+
+    // the budget asks for every unit whenever one is parsed
+    if (measured)
+        return footprint;
+
+    unsigned long ret = 0;
+    CXTUResourceUsage usage = clang_getCXTUResourceUsage(unit);
+    for (unsigned i = 0; i < usage.numEntries; ++i)
+        ret += usage.entries[i].amount;
+
+    clang_disposeCXTUResourceUsage(usage);
+    footprint = ret;
+    measured = true;
+    return ret;
+}
+
+/// declarations
+clang::ast_element translation_unit::ast() {
+    std::lock_guard<std::mutex> guard(lock);
+
+    clang::ast_element root;
+    root.name = path;
+    root.cursor = clang::completion_type::unkown_t;
+    root.access = CX_CXXInvalidAccessSpecifier;
+    root.loc.file = path;
+    root.loc.row = 0;
+    root.loc.col = 0;
+
+    if (unit)
+        clang_visitChildren(clang_getTranslationUnitCursor(unit), ast_visitor, &root);
+
+    return root;
+}
+
+/// diagnostics
+std::vector<clang::diagnostic> translation_unit::diagnose() {
+    std::lock_guard<std::mutex> guard(lock);
+
+    std::vector<clang::diagnostic> ret;
+    if (!unit)
+        return ret;
+
+    unsigned count = clang_getNumDiagnostics(unit);
+    for (unsigned i = 0; i < count; ++i) {
+        CXDiagnostic diag = clang_getDiagnostic(unit, i);
+
+        clang::diagnostic d;
+        d.loc = to_location(clang_getDiagnosticLocation(diag));
+        d.severity = clang_getDiagnosticSeverity(diag);
+        d.text = to_string(clang_formatDiagnostic(diag, clang_defaultDiagnosticDisplayOptions()));
+        d.summary = to_string(clang_getDiagnosticSpelling(diag));
+        ret.push_back(d);
+
+        clang_disposeDiagnostic(diag);
+    }
+
+    return ret;
+}
+
+/// records file as included by the top of the include stack
+static void inclusion_visitor(CXFile file, CXSourceLocation* stack, unsigned depth, CXClientData data) {
+    inclusion_map& out = *static_cast<inclusion_map*>(data);
+    std::string name = to_string(clang_getFileName(file));
+
+    // files including nothing get an entry as well, so their stale includes are dropped
+    out.insert(std::make_pair(name, std::vector<std::string>()));
+    if (depth == 0)
+        return;
+
+    CXFile from;
+    clang_getFileLocation(stack[0], &from, nullptr, nullptr, nullptr);
+    if (from)
+        out[to_string(clang_getFileName(from))].push_back(name);
+}
+
+/// included files
+inclusion_map translation_unit::inclusions() {
+    std::lock_guard<std::mutex> guard(lock);
+
+    inclusion_map ret;
+    if (unit)
+        clang_getInclusions(unit, inclusion_visitor, &ret);
+
+    return ret;
+}
+
+/// appends text to a snippet, $, } and \ have to be escaped
+static void snippet_append(std::string& snippet, const std::string& text) {
+    for (char c : text) {
+        if (c == '$' || c == '}' || c == '\\')
+            snippet += '\\';
+
+        snippet += c;
+    }
+}
+
+/// formats the chunks of str into c, placeholders are numbered from next, params counts the parameters so far
+static void format_chunks(CXCompletionString str, completion_candidate& c, unsigned& next, int32_t& params, bool top) {
+    unsigned chunks = clang_getNumCompletionChunks(str);
+    for (unsigned j = 0; j < chunks; ++j) {
+        CXCompletionChunkKind kind = clang_getCompletionChunkKind(str, j);
+        switch (kind) {
+            case CXCompletionChunk_Optional:
+                // one placeholder around all optional arguments, a single keystroke drops them
+                c.snippet += "${" + std::to_string(next++) + ':';
+                format_chunks(clang_getCompletionChunkCompletionString(str, j), c, next, params, false);
+                c.snippet += '}';
+                break;
+            case CXCompletionChunk_ResultType:
+                if (top)
+                    c.return_type = to_string(clang_getCompletionChunkText(str, j));
+                break;
+            case CXCompletionChunk_Placeholder:
+            case CXCompletionChunk_CurrentParameter: {
+                std::string text = to_string(clang_getCompletionChunkText(str, j));
+                c.snippet += "${" + std::to_string(next++) + ':';
+                snippet_append(c.snippet, text);
+                c.snippet += '}';
+                c.label += text;
+
+                if (kind == CXCompletionChunk_CurrentParameter)
+                    c.active = params;
+                ++params;
+
+                // optional arguments aren't part of args
+                if (top)
+                    c.args.push_back(text);
+                break;
+            }
+            case CXCompletionChunk_Informative:
+                c.label += to_string(clang_getCompletionChunkText(str, j));
+                break;
+            case CXCompletionChunk_VerticalSpace:
+                c.snippet += '\n';
+                c.label += ' ';
+                break;
+            default: {
+                std::string text = to_string(clang_getCompletionChunkText(str, j));
+                snippet_append(c.snippet, text);
+                c.label += text;
+
+                if (kind == CXCompletionChunk_TypedText)
+                    c.name += text;
+                break;
+            }
+        }
+    }
+}
+
+/// code completion
+std::vector<completion_candidate> translation_unit::complete(uint32_t row, uint32_t col, unsigned flags,
+    const char* content, std::size_t length, unsigned long long* contexts)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    std::vector<completion_candidate> ret;
+    if (!unit)
+        return ret;
+
+    // without the unsaved content clang would complete against the files on disk
+    std::vector<CXUnsavedFile> files = unsaved_array(content, length);
+    CXCodeCompleteResults* results = clang_codeCompleteAt(unit, path.c_str(), row, col,
+        files.empty() ? nullptr : &files[0], files.size(), flags);
+
+    if (!results)
+        return ret;
+
+    if (contexts)
+        *contexts = clang_codeCompleteGetContexts(results);
+
+    ret.reserve(results->NumResults);
+    for (unsigned i = 0; i < results->NumResults; ++i) {
+        CXCompletionString str = results->Results[i].CompletionString;
+        if (clang_getCompletionAvailability(str) == CXAvailability_NotAvailable)
+            continue;
+
+        completion_candidate c;
+        c.type = completion_kind(results->Results[i].CursorKind);
+        c.priority = clang_getCompletionPriority(str);
+
+        // code patterns are statements with blanks to fill in, e.g. for(<init>; <cond>; <inc>) { <statements> }
+        bool pattern = false;
+
+        unsigned chunks = clang_getNumCompletionChunks(str);
+        for (unsigned j = 0; j < chunks; ++j) {
+            CXCompletionChunkKind kind = clang_getCompletionChunkKind(str, j);
+            if (kind == CXCompletionChunk_Placeholder || kind == CXCompletionChunk_LeftBrace
+                || kind == CXCompletionChunk_VerticalSpace)
+            {
+                pattern = results->Results[i].CursorKind == CXCursor_NotImplemented;
+            }
+        }
+
+        // clang adds some of them regardless of the flag
+        if (pattern && !(flags & CXCodeComplete_IncludeCodePatterns))
+            continue;
+
+        unsigned next = 1;
+        int32_t params = 0;
+        c.overload = results->Results[i].CursorKind == CXCursor_OverloadCandidate;
+        format_chunks(str, c, next, params, true);
+
+        // overloads spell the function name as plain text
+        if (c.overload && c.name.empty())
+            c.name = c.label.substr(0, c.label.find('('));
+
+        if (flags & CXCodeComplete_IncludeBriefComments)
+            c.brief = to_string(clang_getCompletionBriefComment(str));
+
+        ret.push_back(c);
+    }
+
+    clang_disposeCodeCompleteResults(results);
+    return ret;
+}
+
+/// collects the extents of all cursors in the main file
+static CXChildVisitResult extent_visitor(CXCursor cursor, CXCursor, CXClientData data) {
+    CXSourceRange range = clang_getCursorExtent(cursor);
+    if (!clang_Location_isFromMainFile(clang_getRangeStart(range)))
+        return CXChildVisit_Continue;
+
+    unsigned begin_row, begin_col, end_row, end_col;
+    clang_getExpansionLocation(clang_getRangeStart(range), nullptr, &begin_row, &begin_col, nullptr);
+    clang_getExpansionLocation(clang_getRangeEnd(range), nullptr, &end_row, &end_col, nullptr);
+
+    CXCursorKind kind = clang_getCursorKind(cursor);
+    bool function = kind == CXCursor_FunctionDecl || kind == CXCursor_CXXMethod || kind == CXCursor_Constructor
+        || kind == CXCursor_Destructor || kind == CXCursor_ConversionFunction || kind == CXCursor_FunctionTemplate
+        || kind == CXCursor_LambdaExpr;
+
+    auto visit = static_cast<std::pair<cursor_index*, std::vector<CXCursor>*>*>(data);
+    visit->first->add(begin_row, begin_col, end_row, end_col, visit->second->size(), function);
+    visit->second->push_back(cursor);
+    return CXChildVisit_Recurse;
+}
+
+/// cursor extents
+void translation_unit::index_cursors() {
+    if (indexed || !unit)
+        return;
+
+    std::pair<cursor_index*, std::vector<CXCursor>*> visit(&cursors, &visited);
+    clang_visitChildren(clang_getTranslationUnitCursor(unit), extent_visitor, &visit);
+    cursors.build();
+    indexed = true;
+}
+
+/// type
+std::string translation_unit::cursor_type(uint32_t row, uint32_t col) {
+    return cursor_info(row, col, cursor_field_type).type;
+}
+
+/// declaration
+clang::location translation_unit::cursor_declaration(uint32_t row, uint32_t col) {
+    return cursor_info(row, col, cursor_field_declaration).declaration;
+}
+
+/// definition
+clang::location translation_unit::cursor_definition(uint32_t row, uint32_t col) {
+    return cursor_info(row, col, cursor_field_definition).definition;
+}
+
+/// cursor facets
+cursor_index::entry translation_unit::cursor_info(uint32_t row, uint32_t col, uint32_t fields) {
+    std::lock_guard<std::mutex> guard(lock);
+    index_cursors();
+
+    // nothing at row / col, every facet is empty
+    int32_t i = cursors.find(row, col);
+    if (i < 0) {
+        cursor_index::entry ret;
+        ret.fields = cursor_field_all;
+        ret.declaration = cursor_location(clang_getNullCursor());
+        ret.definition = ret.declaration;
+        return ret;
+    }
+
+    CXCursor cursor = visited[cursors.at(i).cursor];
+    cursor_index::entry& e = cursors.info(i);
+    uint32_t missing = fields & ~e.fields;
+
+    if (missing & cursor_field_type)
+        e.type = to_string(clang_getTypeSpelling(clang_getCursorType(cursor)));
+    if (missing & cursor_field_declaration)
+        e.declaration = cursor_location(clang_getCursorReferenced(cursor));
+    if (missing & cursor_field_definition)
+        e.definition = cursor_location(clang_getCursorDefinition(cursor));
+
+    // comments are attached to the declaration, not to references
+    if (missing & cursor_field_docs) {
+        CXCursor referenced = clang_getCursorReferenced(cursor);
+        e.brief = to_string(clang_Cursor_getBriefCommentText(referenced));
+        e.comment = to_string(clang_Cursor_getRawCommentText(referenced));
+    }
+
+    e.fields |= missing;
+    return e;
+}
+
+/// surrounding function
+function_scope translation_unit::enclosing_function(uint32_t row, uint32_t col) {
+    std::lock_guard<std::mutex> guard(lock);
+    index_cursors();
+
+    function_scope ret;
+    int32_t i = cursors.find_function(row, col);
+    if (i < 0)
+        return ret;
+
+    CXCursor cursor = visited[cursors.at(i).cursor];
+    CXSourceRange range = clang_getCursorExtent(cursor);
+
+    ret.found = true;
+    if (clang_getCursorKind(cursor) != CXCursor_LambdaExpr)
+        ret.name = to_string(clang_getCursorSpelling(cursor));
+
+    ret.begin = to_location(clang_getRangeStart(range));
+    ret.end = to_location(clang_getRangeEnd(range));
+    return ret;
+}
+
+/// arguments
+void unit_cache::arguments_set(const char** args, uint32_t argc) {
+    this->args.assign(args, args + argc);
+}
+
+/// new content
+void unit_cache::index_touch(const char* path, const unsaved_files& unsaved, bool outline) {
+    std::shared_ptr<translation_unit>& u = units[path];
+    if (!u)
+        u = std::make_shared<translation_unit>(path);
+
+    u->parse(args, outline, unsaved);
+}
+
+/// memory usage
+std::map<std::string, unsigned long> unit_cache::index_status() {
+    std::map<std::string, unsigned long> ret;
+    for (auto &entry : units)
+        ret[entry.first] = entry.second->memory();
+
+    return ret;
+}
+
+/// remove
+void unit_cache::index_remove(const char* path) {
+    units.erase(path);
+}
+
+/// clear
+void unit_cache::index_clear() {
+    units.clear();
+}
+
+/// parse from scratch
+void unit_cache::index_renew(const char* path) {
+    auto it = units.find(path);
+    if (it != units.end())
+        it->second->renew();
+}
+
+/// parse all from scratch
+void unit_cache::index_renew_all() {
+    for (auto &entry : units)
+        entry.second->renew();
+}
+
+/// ast
+clang::ast_element unit_cache::tu_ast(const char* path) {
+    std::shared_ptr<translation_unit> u = unit(path);
+    return u ? u->ast() : clang::ast_element();
+}
+
+/// diagnostics
+std::vector<clang::diagnostic> unit_cache::tu_diagnose(const char* path) {
+    std::shared_ptr<translation_unit> u = unit(path);
+    return u ? u->diagnose() : std::vector<clang::diagnostic>();
+}
+
+/// included files
+inclusion_map unit_cache::tu_inclusions(const char* path) {
+    auto it = units.find(path);
+    return it != units.end() ? it->second->inclusions() : inclusion_map();
+}
+
+/// completion
+std::vector<completion_candidate> unit_cache::cursor_complete(const char* path, uint32_t row, uint32_t col) {
+    unsigned flags = CXCodeComplete_IncludeMacros | CXCodeComplete_IncludeCodePatterns | CXCodeComplete_IncludeBriefComments;
+    return cursor_complete(path, row, col, flags, nullptr);
+}
+
+/// completion with flags
+std::vector<completion_candidate> unit_cache::cursor_complete(const char* path, uint32_t row, uint32_t col,
+    unsigned flags, unsigned long long* contexts, const char* content, std::size_t length)
+{
+    // function bodies are where completion happens
+    std::shared_ptr<translation_unit> u = unit(path);
+    if (!u)
+        return {};
+
+    if (u->outline())
+        u->refresh(args, false);
+
+    return u->complete(row, col, flags, content, length, contexts);
+}
+
+/// type
+std::string unit_cache::cursor_type(const char* path, uint32_t row, uint32_t col) {
+    std::shared_ptr<translation_unit> u = unit(path);
+    return u ? u->cursor_type(row, col) : "";
+}
+
+/// declaration
+clang::location unit_cache::cursor_declaration(const char* path, uint32_t row, uint32_t col) {
+    std::shared_ptr<translation_unit> u = unit(path);
+    return u ? u->cursor_declaration(row, col) : clang::location();
+}
+
+/// definition
+clang::location unit_cache::cursor_definition(const char* path, uint32_t row, uint32_t col) {
+    std::shared_ptr<translation_unit> u = unit(path);
+    return u ? u->cursor_definition(row, col) : clang::location();
+}
+
+/// cursor facets
+cursor_index::entry unit_cache::cursor_info(const char* path, uint32_t row, uint32_t col, uint32_t fields) {
+    std::shared_ptr<translation_unit> u = unit(path);
+    return u ? u->cursor_info(row, col, fields) : cursor_index::entry();
+}
+
+/// surrounding function
+function_scope unit_cache::enclosing_function(const char* path, uint32_t row, uint32_t col) {
+    std::shared_ptr<translation_unit> u = unit(path);
+    return u ? u->enclosing_function(row, col) : function_scope();
+}
+
+/// lookup
+std::shared_ptr<translation_unit> unit_cache::unit(const char* path) {
+    auto it = units.find(path);
+    if (it == units.end())
+        return nullptr;
+
+    std::shared_ptr<translation_unit>& u = it->second;
+    if (u->arguments() != args)
+        u->refresh(args, u->outline());
+
+    return u;
+}
@@ -0,0 +1,251 @@
+/**
+* @file unit_cache.hpp
+* @author Robin Dietrich <me (at) invokr (dot) org>
+* @version 1.0
+*
+* @par License
+*   clang-tool
+*   Copyright 2015 Robin Dietrich
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License. *
+*/
+
+#ifndef _CLANG_TOOL_UNIT_CACHE_HPP_
+#define _CLANG_TOOL_UNIT_CACHE_HPP_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <clang-c/Index.h>
+
+#include "clang/clang_tool.hpp"
+#include "completion_filter.hpp"
+#include "cursor_index.hpp"
+#include "include_graph.hpp"
+
+/** Function, method or lambda surrounding a position */
+struct function_scope {
+    /** Whether there is one */
+    bool found;
+    /** Name, empty for lambdas */
+    std::string name;
+    /** Start of the definition */
+    clang::location begin;
+    /** End of the definition, exclusive */
+    clang::location end;
+
+    /** Constructor */
+    function_scope() : found(false) {}
+};
+
+/** Unsaved content of a file, shared with the text_buffer it came from */
+struct unsaved_file {
+    /** Absolute path */
+    std::string path;
+    /** Content, immutable so units and workers can hold on to it */
+    std::shared_ptr<const std::string> content;
+};
+
+/** Unsaved content of every edited file, handed to clang with each parse so included headers see it too */
+typedef std::vector<unsaved_file> unsaved_files;
+
+/**
+ * A translation unit parsed with libclang directly.
+ *
+ * Full units are parsed with a precompiled preamble and cached completion results. Outline units
+ * skip function bodies and have no preamble, they only hold declarations and take a fraction of the
+ * time and memory. Every method locks the unit, so a unit handed to a background thread can be used
+ * there while the cache it belongs to keeps changing.
+ */
+class translation_unit {
+public:
+    /** Constructor */
+    explicit translation_unit(const std::string& path);
+
+    /** Destructor */
+    ~translation_unit();
+
+    translation_unit(const translation_unit&) = delete;
+    translation_unit& operator=(const translation_unit&) = delete;
+
+    /** Parses the file with the unsaved content of any file, reparsing in place if arguments and mode are unchanged */
+    bool parse(const std::vector<std::string>& args, bool outline, unsaved_files unsaved);
+
+    /** Parses the content of the last parse again with new arguments or mode */
+    bool refresh(const std::vector<std::string>& args, bool outline);
+
+    /** Makes the next parse create the unit from scratch, clang only reads -ivfsoverlay files when a unit is created */
+    void renew();
+
+    /** Whether function bodies are skipped */
+    bool outline() const {
+        return skip_bodies;
+    }
+
+    /** Returns the arguments the unit was parsed with */
+    const std::vector<std::string>& arguments() const {
+        return args;
+    }
+
+    /** Returns the memory used by clang in bytes, measured once per parse */
+    unsigned long memory();
+
+    /** Returns the declarations of the file */
+    clang::ast_element ast();
+
+    /** Returns the diagnostics of the last parse */
+    std::vector<clang::diagnostic> diagnose();
+
+    /** Returns the files included by the last parse, see inclusion_map */
+    inclusion_map inclusions();
+
+    /**
+     * Returns completion candidates for the CXCodeComplete_* flags and stores the CXCompletionContext
+     * bits clang determined in contexts. If content is given it replaces the parsed content of the file
+     * without reparsing, the unsaved content of other files is the one of the last parse.
+     */
+    std::vector<completion_candidate> complete(uint32_t row, uint32_t col, unsigned flags, const char* content,
+        std::size_t length, unsigned long long* contexts);
+
+    /** Returns the type under the cursor */
+    std::string cursor_type(uint32_t row, uint32_t col);
+
+    /** Returns where the cursor is declared */
+    clang::location cursor_declaration(uint32_t row, uint32_t col);
+
+    /** Returns where the cursor is defined */
+    clang::location cursor_definition(uint32_t row, uint32_t col);
+
+    /** Returns the requested facets of the cursor at row / col, facets are cached per cursor until the next parse */
+    cursor_index::entry cursor_info(uint32_t row, uint32_t col, uint32_t fields);
+
+    /** Returns the innermost function surrounding row / col */
+    function_scope enclosing_function(uint32_t row, uint32_t col);
+private:
+    /** Parses or reparses content, the lock has to be held */
+    bool load(const std::vector<std::string>& args, bool outline);
+
+    /** Returns the unsaved content for clang, content replaces the one of the file if given */
+    std::vector<CXUnsavedFile> unsaved_array(const char* content, std::size_t length) const;
+
+    /** Collects the cursor extents of the file unless that happened since the last parse, the lock has to be held */
+    void index_cursors();
+
+    /** File parsed */
+    std::string path;
+    /** Index owning the unit, one per unit so units can be used from different threads */
+    CXIndex index;
+    /** Parsed unit, null if parsing failed */
+    CXTranslationUnit unit;
+    /** Arguments the unit was parsed with */
+    std::vector<std::string> args;
+    /** Whether function bodies are skipped */
+    bool skip_bodies;
+    /** Unsaved content the unit was parsed with, the file itself is read from disk if it isn't part of it */
+    unsaved_files unsaved;
+    /** Extents of the cursors in the file */
+    cursor_index cursors;
+    /** Cursors referenced by the extents in cursors */
+    std::vector<CXCursor> visited;
+    /** Whether cursors is up to date */
+    bool indexed;
+    /** Whether the next parse can't reuse the unit, see renew */
+    bool fresh;
+    /** Memory used by clang, valid if measured is set */
+    unsigned long footprint;
+    /** Whether footprint is up to date */
+    bool measured;
+    /** Serializes access between the main thread and background workers */
+    std::mutex lock;
+};
+
+/**
+ * Translation units of any number of files sharing the same arguments.
+ *
+ * Units parsed with other arguments are parsed again the next time they are queried. Queries for
+ * files that aren't on the index return empty results, callers check contains first.
+ */
+class unit_cache {
+public:
+    /** Sets the arguments used for all units */
+    void arguments_set(const char** args, uint32_t argc);
+
+    /** Parses or reparses path with the unsaved content of any file, skipping function bodies if outline is set */
+    void index_touch(const char* path, const unsaved_files& unsaved, bool outline = false);
+
+    /** Returns the memory used by each unit in bytes */
+    std::map<std::string, unsigned long> index_status();
+
+    /** Drops the unit of path */
+    void index_remove(const char* path);
+
+    /** Returns whether path has a unit */
+    bool contains(const char* path) const {
+        return units.count(path) != 0;
+    }
+
+    /** Drops all units */
+    void index_clear();
+
+    /** Makes the next parse of path create its unit from scratch, see translation_unit::renew */
+    void index_renew(const char* path);
+
+    /** Makes the next parse of every unit create it from scratch */
+    void index_renew_all();
+
+    /** Returns the declarations of path */
+    clang::ast_element tu_ast(const char* path);
+
+    /** Returns the diagnostics of path */
+    std::vector<clang::diagnostic> tu_diagnose(const char* path);
+
+    /** Returns the files included by the last parse of path, without parsing it again */
+    inclusion_map tu_inclusions(const char* path);
+
+    /** Returns all completion candidates at row / col, outline units become full ones first */
+    std::vector<completion_candidate> cursor_complete(const char* path, uint32_t row, uint32_t col);
+
+    /** Returns the completion candidates for the CXCodeComplete_* flags, see translation_unit::complete */
+    std::vector<completion_candidate> cursor_complete(const char* path, uint32_t row, uint32_t col, unsigned flags,
+        unsigned long long* contexts, const char* content = nullptr, std::size_t length = 0);
+
+    /** Returns the type under the cursor */
+    std::string cursor_type(const char* path, uint32_t row, uint32_t col);
+
+    /** Returns where the cursor is declared */
+    clang::location cursor_declaration(const char* path, uint32_t row, uint32_t col);
+
+    /** Returns where the cursor is defined */
+    clang::location cursor_definition(const char* path, uint32_t row, uint32_t col);
+
+    /** Returns the requested facets of the cursor at row / col, see cursor_field */
+    cursor_index::entry cursor_info(const char* path, uint32_t row, uint32_t col, uint32_t fields);
+
+    /** Returns the innermost function surrounding row / col */
+    function_scope enclosing_function(const char* path, uint32_t row, uint32_t col);
+
+    /** Returns the up to date unit of path, nullptr if path isn't on the index */
+    std::shared_ptr<translation_unit> unit(const char* path);
+private:
+    /** Arguments of all units */
+    std::vector<std::string> args;
+
+    /** Unit of each file */
+    std::map<std::string, std::shared_ptr<translation_unit>> units;
+};
+
+#endif /* _CLANG_TOOL_UNIT_CACHE_HPP_ */